@@ -17,6 +17,8 @@
 
 import argparse
 import datetime
+import hashlib
+import json
 import os
 import re
 import subprocess
@@ -34,8 +36,9 @@ FONTTEST_VARIATION = FONTTEST_NAMESPACE + "var"
 
 
 class ConformanceChecker:
-    def __init__(self, engine):
+    def __init__(self, engine, zygote=False):
         self.engine = engine
+        self.zygote = zygote
         if self.engine == "OpenType.js":
             self.command = "node_modules/opentype.js/bin/test-render"
         elif self.engine == "fontkit":
@@ -54,9 +57,24 @@ class ConformanceChecker:
         self.reports = {}  # filename --> HTML ElementTree
         self.conformance = {}  # testcase -> True|False
         self.observed = {}  # testcase --> SVG ElementTree
+        self.prerendered = {}  # testcase --> (status, stdout, hash) from --zygote
+        # testcase --> [expected hash, observed hash] of the last passing run,
+        # so that an unchanged rendering passes without comparing coordinates
+        self.known_good_path = "build/known-good-%s.json" % engine
+        self.known_good = {}
+        if zygote and os.path.exists(self.known_good_path):
+            with open(self.known_good_path, "r") as f:
+                self.known_good = json.load(f)
 
     def get_version(self):
-        if self.engine in {"CoreText", "FreeStack", "TehreerStack", "Allsorts", "Swash"}:
+        if self.engine in {
+            "CoreText",
+            "FreeStack",
+            "FreeStackHB",
+            "TehreerStack",
+            "Allsorts",
+            "Swash",
+        }:
             return subprocess.check_output(
                 [self.command, "--version", "--engine=" + self.engine]
             ).decode("utf-8")
@@ -98,20 +116,31 @@ class ConformanceChecker:
     def check(self, testfile):
         doc = etree.parse(testfile).getroot()
         self.reports[testfile] = doc
+        if self.zygote:
+            self.render_in_zygote(
+                doc.findall(".//*[@class='expected']")
+                + doc.findall(".//*[@class='expected-no-crash']")
+            )
         for e in doc.findall(".//*[@class='expected']"):
             testcase = e.attrib[FONTTEST_ID]
-            ok, observed = self.render(e)
+            ok, observed, observed_hash = self.render(e)
             if ok:
                 expected_svg = e.find("svg")
-                self.normalize_svg(expected_svg)
-                ok = svgutil.is_similar(expected_svg, observed, maxDelta=1.0)
+                hashes = [self.hash_expected_svg(expected_svg), observed_hash]
+                if not observed_hash or self.known_good.get(testcase) != hashes:
+                    self.normalize_svg(expected_svg)
+                    ok = svgutil.is_similar(expected_svg, observed, maxDelta=1.0)
+                    if ok and observed_hash:
+                        self.known_good[testcase] = hashes
                 self.add_prefix_to_svg_ids(observed, "OBSERVED")
+            if not ok:
+                self.known_good.pop(testcase, None)
             self.observed[testcase] = observed
             self.conformance[testcase] = ok
             print("%s %s" % ("PASS" if ok else "FAIL", testcase))
         for e in doc.findall(".//*[@class='expected-no-crash']"):
             testcase = e.attrib[FONTTEST_ID]
-            ok, observed = self.render(e)
+            ok, observed, _hash = self.render(e)
             self.add_prefix_to_svg_ids(observed, "OBSERVED")
             self.observed[testcase] = observed
             self.conformance[testcase] = ok
@@ -122,18 +151,68 @@ class ConformanceChecker:
                 group = "/".join(groups[:i])
                 self.conformance[group] = ok and self.conformance.get(group, True)
 
+    def render_in_zygote(self, elements):
+        # One fonttest process renders all testcases of a file. It forks
+        # a child per testcase, so crashes and timeouts stay isolated.
+        records = []
+        for e in elements:
+            record = {
+                "id": e.attrib[FONTTEST_ID],
+                "font": os.path.join("fonts", e.attrib[FONTTEST_FONT]),
+            }
+            if e.attrib.get(FONTTEST_RENDER):
+                record["render"] = e.attrib[FONTTEST_RENDER]
+            if e.attrib.get(FONTTEST_VARIATION):
+                record["variation"] = e.attrib[FONTTEST_VARIATION]
+            records.append(json.dumps(record) + "\n")
+        command = [
+            self.command,
+            "--zygote=-",
+            "--timeout=3",
+            "--canonical",
+            "--engine=" + self.engine,
+        ]
+        output = subprocess.run(
+            command,
+            input="".join(records).encode("utf-8"),
+            stdout=subprocess.PIPE,
+            check=True,
+        ).stdout
+        for line in output.decode("utf-8").splitlines():
+            result = json.loads(line)
+            status = 0 if result["ok"] else 1
+            self.prerendered[result["id"]] = (
+                status,
+                result.get("svg", ""),
+                result.get("hash"),
+            )
+
     def render(self, e):
-        command = self.make_command(e)
-        status, observed, _stderr = run_command(command, timeout_sec=3)
-        observed = observed.decode("utf-8")
+        testcase = e.attrib[FONTTEST_ID]
+        if testcase in self.prerendered:
+            # Canonical SVG from --zygote, which fonttest has normalized.
+            status, observed, observed_hash = self.prerendered.pop(testcase)
+            if status == 0:
+                return (True, etree.fromstring(observed), observed_hash)
+        else:
+            command = self.make_command(e)
+            status, observed, _stderr = run_command(command, timeout_sec=3)
+            observed = observed.decode("utf-8")
         if status == 0:
             observed = re.sub(r">\s+<", "><", observed)
             observed = observed.replace('xmlns="http://www.w3.org/2000/svg"', "")
             observed_svg = etree.fromstring(observed)
             self.normalize_svg(observed_svg)
-            return (True, observed_svg)
+            return (True, observed_svg, None)
         else:
-            return (False, etree.fromstring("<div>&#x2053;</div>"))
+            return (False, etree.fromstring("<div>&#x2053;</div>"), None)
+
+    def hash_expected_svg(self, svg):
+        return hashlib.sha1(etree.tostring(svg)).hexdigest()[:16]
+
+    def save_known_good(self):
+        with open(self.known_good_path, "w") as f:
+            json.dump(self.known_good, f, indent=0, sort_keys=True)
 
     def normalize_svg(self, svg):
         strip_path = lambda p: re.sub(r"\s+", " ", p).strip()
@@ -278,6 +357,7 @@ def main():
         "--engine",
         choices=[
             "FreeStack",
+            "FreeStackHB",
             "TehreerStack",
             "CoreText",
             "DirectWrite",
@@ -289,14 +369,26 @@ def main():
         default="FreeStack",
     )
     parser.add_argument("--output", help="path to report file being written")
+    parser.add_argument(
+        "--zygote",
+        action="store_true",
+        help="fork each test from one fonttest process instead of running "
+        "a new one (FreeStack, FreeStackHB and TehreerStack only)",
+    )
     args = parser.parse_args()
+    if args.zygote and args.engine not in {"FreeStack", "FreeStackHB", "TehreerStack"}:
+        parser.error(
+            "--zygote is only supported for FreeStack, FreeStackHB and TehreerStack"
+        )
     build(engine=args.engine)
-    checker = ConformanceChecker(engine=args.engine)
+    checker = ConformanceChecker(engine=args.engine, zygote=args.zygote)
     for filename in sorted(os.listdir("testcases"), key=sortkey):
         if filename == "index.html" or not filename.endswith(".html"):
             continue
         checker.check(os.path.join("testcases", filename))
     print("PASS" if checker.conformance.get("") else "FAIL")
+    if args.zygote:
+        checker.save_known_good()
     if args.output:
         checker.write_report(args.output)
 
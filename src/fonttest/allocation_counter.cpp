@@ -0,0 +1,57 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "fonttest/allocation_counter.h"
+
+namespace fonttest {
+
+namespace {
+
+std::atomic<uint64_t> allocationCount(0);
+
+}  // namespace
+
+uint64_t GetAllocationCount() {
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+}  // namespace fonttest
+
+void* operator new(std::size_t size) {
+  fonttest::allocationCount.fetch_add(1, std::memory_order_relaxed);
+  void* block = std::malloc(size > 0 ? size : 1);
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  return block;
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* block) noexcept {
+  std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+  std::free(block);
+}
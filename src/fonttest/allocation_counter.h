@@ -0,0 +1,30 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_ALLOCATION_COUNTER_H_
+#define FONTTEST_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace fonttest {
+
+// Returns how many times the global operator new has been called in this
+// process. Only fonttest_bench links allocation_counter.cpp, which
+// replaces operator new; C libraries that call malloc() are not counted.
+uint64_t GetAllocationCount();
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_ALLOCATION_COUNTER_H_
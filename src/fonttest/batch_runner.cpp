@@ -0,0 +1,114 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "fonttest/batch_runner.h"
+#include "fonttest/json.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+BatchRunner::BatchRunner(const std::string& engineName, int numThreads)
+  : runner_(engineName, numThreads), format_(kFormatSVG) {
+}
+
+BatchRunner::~BatchRunner() {
+}
+
+void BatchRunner::SetOutputFormat(OutputFormat format, bool withOutlines) {
+  format_ = format;
+  runner_.SetOutputFormat(format, withOutlines);
+}
+
+bool BatchRunner::ParseJob(const std::string& line, RenderJob* job,
+                           std::string* error) {
+  JSONRecord record;
+  return ParseJob(line, job, &record, error);
+}
+
+bool BatchRunner::ParseJob(const std::string& line, RenderJob* job,
+                           JSONRecord* record, std::string* error) {
+  if (!ParseJSONRecord(line, record, error)) {
+    return false;
+  }
+
+  job->id = (*record)["id"];
+  job->fontPath = (*record)["font"];
+  job->text = (*record)["render"];
+  job->textLanguage = (*record)["textLanguage"];
+  job->variationSpec = (*record)["variation"];
+  job->faceIndex = std::atoi((*record)["faceIndex"].c_str());
+  if (job->fontPath.empty()) {
+    *error = "missing \"font\"";
+    return false;
+  }
+  return true;
+}
+
+void BatchRunner::FormatResult(const RenderJob& job,
+                               const RenderResult& result,
+                               OutputFormat format, std::string* out) {
+  out->append("{\"id\":");
+  AppendJSONString(job.id, out);
+  if (result.ok && format == kFormatGlyphsJSON) {
+    out->append(",\"ok\":true,\"glyphs\":");
+    out->append(result.output);
+  } else if (result.ok) {
+    out->append(",\"ok\":true,\"svg\":");
+    AppendJSONString(result.output, out);
+    if (result.hash) {
+      char hash[32];
+      snprintf(hash, sizeof(hash), ",\"hash\":\"%016llx\"",
+               static_cast<unsigned long long>(result.hash));
+      out->append(hash);
+    }
+  } else {
+    out->append(",\"ok\":false,\"error\":");
+    AppendJSONString(result.error, out);
+  }
+  out->append("}\n");
+}
+
+void BatchRunner::Run(std::istream* input, std::ostream* output) {
+  std::string formatted;
+  const OutputFormat format = format_;
+  runner_.Start([output, format, &formatted](const RenderJob& job,
+                                             const RenderResult& result) {
+    formatted.clear();
+    FormatResult(job, result, format, &formatted);
+    *output << formatted << std::flush;
+  });
+
+  std::string line, error;
+  while (std::getline(*input, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+
+    RenderJob job;
+    if (ParseJob(line, &job, &error)) {
+      runner_.Add(job);
+    } else {
+      runner_.AddFailed(job, "malformed batch record: " + error);
+    }
+  }
+  runner_.Finish();
+}
+
+}  // namespace fonttest
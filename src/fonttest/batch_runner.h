@@ -0,0 +1,76 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_BATCH_RUNNER_H_
+#define FONTTEST_BATCH_RUNNER_H_
+
+#include <iosfwd>
+#include <string>
+
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/json.h"
+#include "fonttest/parallel_runner.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+// Renders a stream of testcases in a single process. The input is
+// in JSON Lines format, with one record per testcase:
+//
+//   {"id": "AVAR-1/1", "font": "fonts/TestAVAR.ttf", "render": "A",
+//    "variation": "WGHT:700", "textLanguage": "en", "faceIndex": 0}
+//
+// Testcases are rendered in parallel by a ParallelRunner. For every input
+// record, one result record is written to the output, in input order,
+// as soon as it and all its predecessors are available:
+//
+//   {"id": "AVAR-1/1", "ok": true, "svg": "<?xml ..."}
+//   {"id": "AVAR-1/2", "ok": false, "error": "failed to load font: ..."}
+//
+// With the glyphs output format, "svg" is replaced by a "glyphs" object
+// as written by AppendGlyphRunJSON(). The binary format is not supported
+// in batch mode. If the ParallelRunner produces canonical SVG, records
+// also have a "hash" with the 16 hex digits of HashCanonicalSVG().
+class BatchRunner {
+ public:
+  BatchRunner(const std::string& engineName, int numThreads);
+  ~BatchRunner();
+
+  bool IsValid() const { return runner_.IsValid(); }
+  ParallelRunner* GetParallelRunner() { return &runner_; }
+
+  // Must be called before Run(); only kFormatSVG and kFormatGlyphsJSON
+  // are supported.
+  void SetOutputFormat(OutputFormat format, bool withOutlines);
+  void Run(std::istream* input, std::ostream* output);
+
+  static bool ParseJob(const std::string& line, RenderJob* job,
+                       std::string* error);
+
+  // Like above, but also returns the whole record, for callers that
+  // accept more fields than a RenderJob has.
+  static bool ParseJob(const std::string& line, RenderJob* job,
+                       JSONRecord* record, std::string* error);
+  static void FormatResult(const RenderJob& job, const RenderResult& result,
+                           OutputFormat format, std::string* out);
+
+ private:
+  ParallelRunner runner_;
+  OutputFormat format_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_BATCH_RUNNER_H_
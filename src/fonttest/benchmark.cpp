@@ -0,0 +1,110 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fonttest/allocation_counter.h"
+#include "fonttest/benchmark.h"
+
+namespace fonttest {
+
+BenchmarkRunner::BenchmarkRunner(const std::vector<std::string>& args)
+  : valid_(true), fontDir_("fonts"), corpusDir_("src/fonttest/corpus"),
+    minSeconds_(0.5), sink_(0) {
+  for (size_t i = 1; i < args.size(); ++i) {
+    const std::string& arg = args[i];
+    if (arg.find("--filter=") == 0) {
+      filter_ = arg.substr(9);
+    } else if (arg.find("--fonts=") == 0) {
+      fontDir_ = arg.substr(8);
+    } else if (arg.find("--corpus=") == 0) {
+      corpusDir_ = arg.substr(9);
+    } else if (arg.find("--min-time=") == 0) {
+      minSeconds_ = atof(arg.substr(11).c_str());
+    } else {
+      valid_ = false;
+    }
+  }
+}
+
+BenchmarkRunner::~BenchmarkRunner() {
+}
+
+void BenchmarkRunner::PrintUsage() {
+  std::cerr << "usage: fonttest_bench [--filter=substring] "
+            << "[--min-time=seconds] [--fonts=path/to/fonts] "
+            << "[--corpus=path/to/corpus]" << std::endl;
+}
+
+bool BenchmarkRunner::IsEnabled(const std::string& name) const {
+  return filter_.empty() || name.find(filter_) != std::string::npos;
+}
+
+void BenchmarkRunner::Run(const std::string& name, size_t itemsPerIteration,
+                          const Body& body) {
+  std::vector<Rate> rates;
+  if (itemsPerIteration > 0) {
+    rates.push_back(Rate("items", itemsPerIteration));
+  }
+  Run(name, rates, body);
+}
+
+void BenchmarkRunner::Run(const std::string& name,
+                          const std::vector<Rate>& rates, const Body& body) {
+  if (!IsEnabled(name)) {
+    return;
+  }
+
+  typedef std::chrono::steady_clock Clock;
+  body();  // warm up caches before measuring
+  uint64_t iterations = 0;
+  const uint64_t startAllocations = GetAllocationCount();
+  const Clock::time_point start = Clock::now();
+  double elapsed = 0;
+  uint64_t batch = 1;
+  while (elapsed < minSeconds_) {
+    for (uint64_t i = 0; i < batch; ++i) {
+      body();
+    }
+    iterations += batch;
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    if (batch < (1 << 20)) {
+      batch *= 2;
+    }
+  }
+
+  const double nanosPerIteration = elapsed * 1e9 / iterations;
+  const double allocationsPerIteration =
+      static_cast<double>(GetAllocationCount() - startAllocations) /
+      iterations;
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer), "%-48s %12llu %14.1f ns %10.1f allocs",
+           name.c_str(), static_cast<unsigned long long>(iterations),
+           nanosPerIteration, allocationsPerIteration);
+  std::cout << buffer;
+  for (const Rate& rate : rates) {
+    snprintf(buffer, sizeof(buffer), " %14.0f %s/s",
+             rate.perIteration * iterations / elapsed, rate.unit.c_str());
+    std::cout << buffer;
+  }
+  std::cout << std::endl;
+}
+
+}  // namespace fonttest
@@ -0,0 +1,85 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_BENCHMARK_H_
+#define FONTTEST_BENCHMARK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fonttest {
+
+// A small timing harness for fonttest_bench. Every benchmark body is run
+// repeatedly until a minimum wall time has passed; the runner reports
+// the time and the operator new calls per iteration and, if the body
+// processes a known number of items (glyphs, path segments, ...), the
+// throughput.
+class BenchmarkRunner {
+ public:
+  typedef std::function<void()> Body;
+
+  // A throughput to report, such as 40 "glyphs" per iteration.
+  struct Rate {
+    Rate(const std::string& unit, size_t perIteration)
+      : unit(unit), perIteration(perIteration) {}
+    std::string unit;
+    size_t perIteration;
+  };
+
+  explicit BenchmarkRunner(const std::vector<std::string>& args);
+  ~BenchmarkRunner();
+
+  bool IsValid() const { return valid_; }
+  const std::string& GetFontDir() const { return fontDir_; }
+  const std::string& GetCorpusDir() const { return corpusDir_; }
+  static void PrintUsage();
+
+  // Returns false if |name| is excluded by --filter.
+  bool IsEnabled(const std::string& name) const;
+
+  // Runs |body| unless |name| is excluded by --filter.
+  void Run(const std::string& name, size_t itemsPerIteration,
+           const Body& body);
+  void Run(const std::string& name, const std::vector<Rate>& rates,
+           const Body& body);
+
+  // Keeps the compiler from discarding computations whose result
+  // is otherwise unused.
+  void Consume(size_t value) { sink_ = sink_ + value; }
+
+ private:
+  bool valid_;
+  std::string filter_;
+  std::string fontDir_;
+  std::string corpusDir_;
+  double minSeconds_;
+  volatile size_t sink_;
+};
+
+// Benchmark suites, one per stage.
+void RunEngineBenchmarks(BenchmarkRunner* runner);
+void RunParagraphBenchmarks(BenchmarkRunner* runner);
+void RunPathBenchmarks(BenchmarkRunner* runner);
+
+// Checks that rendering a cached font through a Renderer, once warmed up,
+// makes no calls to operator new. Returns false if any render does.
+bool CheckEngineAllocations(BenchmarkRunner* runner);
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_BENCHMARK_H_
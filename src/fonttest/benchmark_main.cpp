@@ -0,0 +1,37 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "fonttest/benchmark.h"
+
+int main(int argc, const char** argv) {
+  std::vector<std::string> args;
+  for (int i = 0; i < argc; ++i) {
+    args.push_back(argv[i]);
+  }
+
+  fonttest::BenchmarkRunner runner(args);
+  if (!runner.IsValid()) {
+    fonttest::BenchmarkRunner::PrintUsage();
+    return 1;
+  }
+
+  fonttest::RunEngineBenchmarks(&runner);
+  fonttest::RunParagraphBenchmarks(&runner);
+  fonttest::RunPathBenchmarks(&runner);
+  return fonttest::CheckEngineAllocations(&runner) ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "fonttest/disk_cache.h"
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+// Bump the version whenever fonttest's output changes; see disk_cache.h.
+static const char kEntryMagic[] = "fonttest render cache 3\n";
+
+static void HashBytes(const char* data, size_t length, uint64_t* hash) {
+  for (size_t i = 0; i < length; ++i) {  // FNV-1a
+    *hash ^= static_cast<unsigned char>(data[i]);
+    *hash *= 1099511628211ULL;
+  }
+}
+
+// Appends |value| with a length prefix, so that no two sequences of
+// fields give the same key.
+static void AppendField(const std::string& value, std::string* key) {
+  key->append(std::to_string(value.size()));
+  key->push_back(':');
+  key->append(value);
+  key->push_back('\n');
+}
+
+DiskCache::DiskCache(const std::string& directory)
+  : directory_(directory) {
+}
+
+DiskCache::~DiskCache() {
+}
+
+bool DiskCache::MakeKey(const std::string& engineVersion,
+                        const RenderJob& job, OutputFormat format,
+                        bool withOutlines, bool canonical,
+                        std::string* key) {
+  int64_t fontSize;
+  uint64_t fontHash;
+  if (!GetFontHash(job.fontPath, &fontSize, &fontHash)) {
+    return false;
+  }
+
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx",
+           static_cast<unsigned long long>(fontHash));
+  key->clear();
+  AppendField(engineVersion, key);
+  AppendField(std::to_string(fontSize), key);
+  AppendField(hex, key);
+  AppendField(std::to_string(job.faceIndex), key);
+  AppendField(job.id, key);  // SVG output uses it for symbol names
+  AppendField(job.text, key);
+  AppendField(job.textLanguage, key);
+  AppendField(job.variationSpec, key);
+  AppendField(std::to_string(static_cast<int>(format)), key);
+  AppendField(withOutlines ? "outlines" : "", key);
+  AppendField(canonical ? "canonical" : "", key);
+  return true;
+}
+
+bool DiskCache::Lookup(const std::string& key, std::string* output) {
+  std::string dir;
+  std::ifstream input(GetEntryPath(key, &dir).c_str(), std::ios::binary);
+  if (input) {
+    std::stringstream contents;
+    contents << input.rdbuf();
+    const std::string entry = contents.str();
+    std::string header(kEntryMagic);
+    header.append(key);
+    if (entry.compare(0, header.size(), header) == 0) {
+      output->assign(entry, header.size(), std::string::npos);
+      ++stats_.hits;
+      return true;
+    }
+  }
+  ++stats_.misses;
+  return false;
+}
+
+void DiskCache::Store(const std::string& key, const std::string& output) {
+  std::string dir;
+  const std::string path = GetEntryPath(key, &dir);
+  mkdir(directory_.c_str(), 0777);
+  mkdir(dir.c_str(), 0777);
+
+  std::string tempPath = path + ".XXXXXX";
+  const int fd = mkstemp(&tempPath[0]);
+  if (fd < 0) {
+    return;  // a cache that cannot be written is merely slow
+  }
+  std::string entry(kEntryMagic);
+  entry.append(key);
+  entry.append(output);
+  const char* data = entry.data();
+  size_t remaining = entry.size();
+  bool ok = true;
+  while (ok && remaining > 0) {
+    const ssize_t written = write(fd, data, remaining);
+    ok = written > 0;
+    if (ok) {
+      data += written;
+      remaining -= static_cast<size_t>(written);
+    }
+  }
+  // mkstemp() creates the file for its owner only, but the cache may be
+  // shared with processes of other users. If this fails, they merely
+  // miss the entry.
+  fchmod(fd, 0644);
+  ok = close(fd) == 0 && ok;
+  if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+    unlink(tempPath.c_str());
+    return;
+  }
+  ++stats_.stores;
+}
+
+// Hashes the contents of a font file. The hash is remembered until the
+// file's modification time or size change; touching a font without
+// changing it therefore costs one more hashing, but keeps the entries.
+bool DiskCache::GetFontHash(const std::string& path, int64_t* fileSize,
+                            uint64_t* hash) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return false;
+  }
+  const int64_t mtime = static_cast<int64_t>(info.st_mtime);
+  *fileSize = static_cast<int64_t>(info.st_size);
+  auto found = fontHashes_.find(path);
+  if (found != fontHashes_.end() && found->second.mtime == mtime &&
+      found->second.fileSize == *fileSize) {
+    *hash = found->second.hash;
+    return true;
+  }
+
+  std::ifstream input(path.c_str(), std::ios::binary);
+  if (!input) {
+    return false;
+  }
+  FontHash fontHash;
+  fontHash.mtime = mtime;
+  fontHash.fileSize = *fileSize;
+  fontHash.hash = 14695981039346656037ULL;
+  char buffer[65536];
+  while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+    HashBytes(buffer, static_cast<size_t>(input.gcount()), &fontHash.hash);
+  }
+  fontHashes_[path] = fontHash;
+  *hash = fontHash.hash;
+  return true;
+}
+
+// Entries are spread over 256 subdirectories, named after the first
+// two hex digits of the key hash.
+std::string DiskCache::GetEntryPath(const std::string& key,
+                                    std::string* dir) const {
+  uint64_t hash = 14695981039346656037ULL;
+  HashBytes(key.data(), key.size(), &hash);
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx",
+           static_cast<unsigned long long>(hash));
+  *dir = directory_ + "/" + std::string(hex, 2);
+  return *dir + "/" + std::string(hex + 2);
+}
+
+}  // namespace fonttest
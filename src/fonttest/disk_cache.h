@@ -0,0 +1,91 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_DISK_CACHE_H_
+#define FONTTEST_DISK_CACHE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+// A persistent cache of rendered output, so that running the test suite
+// again only renders the testcases whose inputs have changed. Entries
+// are keyed by everything that can affect the output: the engine name
+// and version string (which lists the versions of the libraries in
+// third_party), the size and a 64-bit hash of the font file's contents,
+// and the job and output format. Only the contents of a font matter,
+// not its path or modification time.
+//
+// The key does not cover fonttest's own code. Whenever a change to
+// fonttest changes its output for the same inputs (in the engines, the
+// SVG emitter, the path writer or the canonical form), bump the version
+// in kEntryMagic, so that existing entries are no longer used.
+//
+// Every entry is a file in |directory|, named after the hash of its key.
+// The file repeats the full key, so that a collision of the file names
+// is a miss rather than a wrong result. Two different fonts of the same
+// size with the same 64-bit hash would share their entries; this is no
+// protection against fonts made to collide. Entries are written to a
+// temporary file, made readable by everyone, and then renamed, so that
+// several threads and processes (also of other users) can share the
+// directory. A DiskCache object itself is not thread-safe.
+class DiskCache {
+ public:
+  struct Stats {
+    Stats() : hits(0), misses(0), stores(0) {}
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+  };
+
+  explicit DiskCache(const std::string& directory);
+  ~DiskCache();
+
+  // Builds the cache key for rendering |job|. Returns false if the font
+  // cannot be read, in which case rendering is going to fail anyway.
+  bool MakeKey(const std::string& engineVersion, const RenderJob& job,
+               OutputFormat format, bool withOutlines, bool canonical,
+               std::string* key);
+
+  // On a hit, replaces |output| by the cached output and returns true.
+  bool Lookup(const std::string& key, std::string* output);
+  void Store(const std::string& key, const std::string& output);
+
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  struct FontHash {
+    int64_t mtime;
+    int64_t fileSize;
+    uint64_t hash;
+  };
+
+  bool GetFontHash(const std::string& path, int64_t* fileSize,
+                   uint64_t* hash);
+  std::string GetEntryPath(const std::string& key, std::string* dir) const;
+
+  const std::string directory_;
+  std::map<std::string, FontHash> fontHashes_;  // by path
+  Stats stats_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_DISK_CACHE_H_
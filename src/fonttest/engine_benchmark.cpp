@@ -0,0 +1,297 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+
+#include "fonttest/allocation_counter.h"
+#include "fonttest/benchmark.h"
+#include "fonttest/font_engine.h"
+#include "fonttest/freestack_font.h"
+#include "fonttest/freestack_line.h"
+#include "fonttest/freestack_path.h"
+#include "fonttest/glyph_run.h"
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/harfbuzz_line.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/renderer.h"
+#include "fonttest/svg_emitter.h"
+#include "fonttest/tehreerstack_line.h"
+
+namespace fonttest {
+
+namespace {
+
+// Inputs taken from the test suite, chosen to cover the different
+// outline formats, variations and complex shaping.
+struct EngineBenchmarkCase {
+  const char* name;
+  const char* font;
+  const char* text;
+  const char* variation;
+};
+
+const EngineBenchmarkCase kCases[] = {
+  {"CFF-1", "FDArrayTest257.otf", "A", ""},
+  {"CFF2-1", "AdobeVFPrototype-Subset.otf", "$", "wght:100"},
+  {"GVAR-1", "TestGVAROne.ttf", "\xE5\xBD\x8C", "wght:300"},  // U+5F4C
+  {"KERN-2", "TestKERNOne.otf", "u\xC4\xB1\xC4\xB1T\xC4\xB1\xC4\xB1T"
+   "\xC4\xB1\xC4\xB1u", ""},  // uııTııTııu
+  {"SHARAN-1", "TestShapeAran.ttf",
+   "\xD9\x84\xD8\xB3\xD8\xA7\xD9\x86", ""},  // لسان
+  {"SHKNDA-1", "NotoSerifKannada-Regular.ttf",
+   "\xE0\xB2\xB2\xE0\xB3\x8D\xE0\xB2\xB2\xE0\xB2\xBF", ""},  // ಲ್ಲಿ
+};
+
+// All engines render through FreeType, so their fonts are FreeStackFonts.
+const char* const kEngines[] = {"FreeStack", "FreeStackHB", "TehreerStack"};
+
+template <class Line>
+void RunShapingBenchmark(BenchmarkRunner* runner, const std::string& name,
+                         const EngineBenchmarkCase& c, FT_Face face,
+                         GlyphRun* run) {
+  Line(c.text, "", face, Renderer::kFontSize).GetGlyphRun(run);
+  runner->Run(name, run->GetSize(), [&]() {
+    Line line(c.text, "", face, Renderer::kFontSize);
+    line.GetGlyphRun(run);
+    runner->Consume(run->GetSize());
+  });
+}
+
+// Like above, for a line that shapes with the font's cached HarfBuzz
+// objects; |font| must be set up for the instance to shape with.
+void RunHarfBuzzShapingBenchmark(BenchmarkRunner* runner,
+                                 const std::string& name,
+                                 const EngineBenchmarkCase& c,
+                                 FreeStackFont* font, GlyphRun* run) {
+  HarfBuzzInstance* instance = font->GetHarfBuzzInstance();
+  HarfBuzzLine(c.text, "", instance).GetGlyphRun(run);
+  runner->Run(name, run->GetSize(), [&]() {
+    HarfBuzzLine line(c.text, "", instance);
+    line.GetGlyphRun(run);
+    runner->Consume(run->GetSize());
+  });
+}
+
+// Like above, for a line that shapes with the font's cached SheenFigure
+// font and patterns.
+void RunSheenFigureShapingBenchmark(BenchmarkRunner* runner,
+                                    const std::string& name,
+                                    const EngineBenchmarkCase& c,
+                                    FreeStackFont* font, GlyphRun* run) {
+  SheenFigureInstance* instance = font->GetSheenFigureInstance();
+  TehreerStackLine(c.text, "", instance, Renderer::kFontSize)
+      .GetGlyphRun(run);
+  runner->Run(name, run->GetSize(), [&]() {
+    TehreerStackLine line(c.text, "", instance, Renderer::kFontSize);
+    line.GetGlyphRun(run);
+    runner->Consume(run->GetSize());
+  });
+}
+
+void RunConvertBenchmark(BenchmarkRunner* runner, const std::string& name,
+                         FT_Face face, const GlyphRun& run) {
+  std::vector<FT_Outline> outlines;
+  for (uint32_t glyphID : run.glyphIDs) {
+    if (FT_Load_Glyph(face, glyphID, FT_LOAD_NO_HINTING|FT_LOAD_NO_BITMAP)) {
+      std::cerr << name << ": FT_Load_Glyph() failed" << std::endl;
+      exit(1);
+    }
+    const FT_Outline& source = face->glyph->outline;
+    FT_Outline outline;
+    FT_Outline_New(face->glyph->library, source.n_points, source.n_contours,
+                   &outline);
+    FT_Outline_Copy(&source, &outline);
+    outlines.push_back(outline);
+  }
+
+  std::string path;
+  FT_Vector transform;
+  transform.x = transform.y = 0;
+  runner->Run(name, outlines.size(), [&]() {
+    path.clear();
+    FreeTypePathConverter converter(transform);
+    for (FT_Outline& outline : outlines) {
+      converter.Convert(&outline, &path);
+    }
+    runner->Consume(path.size());
+  });
+
+  for (FT_Outline& outline : outlines) {
+    FT_Outline_Done(face->glyph->library, &outline);
+  }
+}
+
+void RunCaseBenchmarks(BenchmarkRunner* runner, FontEngine* engine,
+                       const EngineBenchmarkCase& c) {
+  const std::string prefix = "/" + engine->GetName() + "/" + c.name;
+  const std::string path = runner->GetFontDir() + "/" + c.font;
+  std::unique_ptr<Font> font(engine->LoadFont(path, 0));
+  if (!font) {
+    std::cerr << "failed to load font: " << path << std::endl;
+    exit(1);
+  }
+
+  FontVariation variation, defaultVariation;
+  if (!ParseVariationSpec(c.variation, &variation)) {
+    std::cerr << "malformed variation: " << c.variation << std::endl;
+    exit(1);
+  }
+
+  runner->Run("load" + prefix, 0, [&]() {
+    std::unique_ptr<Font> loaded(engine->LoadFont(path, 0));
+    runner->Consume(loaded ? 1 : 0);
+  });
+
+  // An unchanged instance takes the fast path in GetFace(); switching
+  // makes FreeType apply the size or the design coordinates every time.
+  FreeStackFont* freeStackFont = static_cast<FreeStackFont*>(font.get());
+  const double size = Renderer::kFontSize;
+  runner->Run("face" + prefix + "/same", 0, [&]() {
+    runner->Consume(freeStackFont->GetFace(size, variation) != NULL);
+  });
+  if (variation.empty()) {
+    bool larger = false;
+    runner->Run("face" + prefix + "/switch_size", 0, [&]() {
+      larger = !larger;
+      FT_Face face = freeStackFont->GetFace(larger ? 2 * size : size,
+                                            variation);
+      runner->Consume(face != NULL);
+    });
+  } else {
+    bool varied = false;
+    runner->Run("face" + prefix + "/switch_variation", 0, [&]() {
+      varied = !varied;
+      FT_Face face = freeStackFont->GetFace(
+          size, varied ? variation : defaultVariation);
+      runner->Consume(face != NULL);
+    });
+  }
+
+  FT_Face face = freeStackFont->GetFace(size, variation);
+  GlyphRun run;
+  if (engine->GetName() == "FreeStack") {
+    RunShapingBenchmark<FreeStackLine>(runner, "shape" + prefix, c, face,
+                                       &run);
+  } else if (engine->GetName() == "FreeStackHB") {
+    RunHarfBuzzShapingBenchmark(runner, "shape" + prefix, c, freeStackFont,
+                                &run);
+  } else {
+    RunSheenFigureShapingBenchmark(runner, "shape" + prefix, c,
+                                   freeStackFont, &run);
+  }
+
+  RunConvertBenchmark(runner, "convert" + prefix, face, run);
+
+  // Emission with the engine's warm outline cache, and without any cache
+  // so that every outline gets loaded and converted again.
+  SVGEmitter emitter;
+  std::string svg;
+  OutlineCache* outlineCache = engine->GetOutlineCache();
+  OutlineCache::Instance* instance =
+      outlineCache->GetInstance(freeStackFont->GetInstanceKey());
+  runner->Run("emit" + prefix, run.GetSize(), [&]() {
+    emitter.Emit(run, face, size, c.name, outlineCache, instance, &svg);
+    runner->Consume(svg.size());
+  });
+  runner->Run("emit" + prefix + "/uncached", run.GetSize(), [&]() {
+    emitter.Emit(run, face, size, c.name, NULL, NULL, &svg);
+    runner->Consume(svg.size());
+  });
+
+  // All stages together, the way the test harness renders.
+  runner->Run("render" + prefix, run.GetSize(), [&]() {
+    engine->RenderSVG(c.text, "", font.get(), size, variation, c.name, &svg);
+    runner->Consume(svg.size());
+  });
+}
+
+// Renders the same job repeatedly, the way a batch does for testcases
+// of one font, and returns the operator new calls per render once the
+// caches and scratch buffers have been warmed up.
+double CountRenderAllocations(Renderer* renderer, const RenderJob& job) {
+  const int kWarmups = 2, kRenders = 10;
+  RenderResult result;
+  for (int i = 0; i < kWarmups; ++i) {
+    if (!renderer->Render(job, &result)) {
+      std::cerr << job.id << ": " << result.error << std::endl;
+      exit(1);
+    }
+  }
+  const uint64_t start = GetAllocationCount();
+  for (int i = 0; i < kRenders; ++i) {
+    renderer->Render(job, &result);
+  }
+  return static_cast<double>(GetAllocationCount() - start) / kRenders;
+}
+
+}  // namespace
+
+bool CheckEngineAllocations(BenchmarkRunner* runner) {
+  const OutputFormat kFormats[] = {kFormatSVG, kFormatGlyphsJSON};
+  const char* const kFormatNames[] = {"svg", "glyphs"};
+  bool ok = true;
+  for (const char* engineName : kEngines) {
+    std::unique_ptr<FontEngine> engine(FontEngine::Create(engineName));
+    if (!engine) {
+      continue;
+    }
+    Renderer renderer(engine.get());
+    for (int f = 0; f < 2; ++f) {
+      renderer.SetOutputFormat(kFormats[f], false);
+      for (const EngineBenchmarkCase& c : kCases) {
+        const std::string name = std::string("allocations/") + engineName +
+            "/" + c.name + "/" + kFormatNames[f];
+        if (!runner->IsEnabled(name)) {
+          continue;
+        }
+        RenderJob job;
+        job.id = c.name;
+        job.fontPath = runner->GetFontDir() + "/" + c.font;
+        job.text = c.text;
+        job.variationSpec = c.variation;
+        const double allocations = CountRenderAllocations(&renderer, job);
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "%-48s %10.1f allocs per render%s",
+                 name.c_str(), allocations, allocations > 0 ? "  FAIL" : "");
+        std::cout << buffer << std::endl;
+        ok = ok && allocations == 0;
+      }
+    }
+  }
+  return ok;
+}
+
+void RunEngineBenchmarks(BenchmarkRunner* runner) {
+  for (const char* engineName : kEngines) {
+    std::unique_ptr<FontEngine> engine(FontEngine::Create(engineName));
+    if (!engine) {
+      continue;
+    }
+    for (const EngineBenchmarkCase& c : kCases) {
+      RunCaseBenchmarks(runner, engine.get(), c);
+    }
+  }
+}
+
+}  // namespace fonttest
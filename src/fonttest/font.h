@@ -28,7 +28,8 @@ class Font {
   virtual ~Font() {}
 
   // Returns the path of a glyph outline, in SVG path format.
-  // For example, "M 100 100 L 300 100 L 200 300 Z",
+  // For example, "M 100 100 L 300 100 L 200 300 Z". Both strings are
+  // empty if the glyph cannot be loaded.
   virtual void GetGlyphOutline(int glyphID, const FontVariation& variation,
                                std::string* path, std::string* viewBox) = 0;
 };
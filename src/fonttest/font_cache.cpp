@@ -0,0 +1,98 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+
+#include <sys/stat.h>
+
+#include "fonttest/font.h"
+#include "fonttest/font_cache.h"
+#include "fonttest/font_engine.h"
+
+namespace fonttest {
+
+FontCache::FontCache(FontEngine* engine)
+  : engine_(engine), capacity_(kDefaultCapacity) {
+}
+
+FontCache::~FontCache() {
+}
+
+std::shared_ptr<Font> FontCache::Get(const std::string& path, int faceIndex) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return std::shared_ptr<Font>();
+  }
+  const int64_t mtime = static_cast<int64_t>(info.st_mtime);
+  const int64_t fileSize = static_cast<int64_t>(info.st_size);
+
+  // Built in a member, whose capacity survives from call to call,
+  // so that a cache hit does not allocate.
+  std::string& key = key_;
+  key.assign(path);
+  key.push_back('\0');
+  key.append(std::to_string(faceIndex));
+
+  auto found = index_.find(key);
+  if (found != index_.end()) {
+    EntryList::iterator entry = found->second;
+    if (entry->mtime == mtime && entry->fileSize == fileSize) {
+      ++stats_.hits;
+      entries_.splice(entries_.begin(), entries_, entry);
+      return entry->font;
+    }
+
+    // The file has changed on disk since we loaded it.
+    entries_.erase(entry);
+    index_.erase(found);
+  }
+
+  ++stats_.misses;
+  std::shared_ptr<Font> font(engine_->LoadFont(path, faceIndex));
+  if (!font) {
+    return font;
+  }
+
+  Entry entry;
+  entry.key = key;
+  entry.mtime = mtime;
+  entry.fileSize = fileSize;
+  entry.font = font;
+  entries_.push_front(entry);
+  index_[key] = entries_.begin();
+  EvictToCapacity();
+  return font;
+}
+
+void FontCache::SetCapacity(size_t capacity) {
+  capacity_ = capacity > 0 ? capacity : 1;
+  EvictToCapacity();
+}
+
+void FontCache::Clear() {
+  index_.clear();
+  entries_.clear();
+}
+
+void FontCache::EvictToCapacity() {
+  while (entries_.size() > capacity_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+    ++stats_.evictions;
+  }
+}
+
+}  // namespace fonttest
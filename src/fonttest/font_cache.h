@@ -0,0 +1,80 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_FONT_CACHE_H_
+#define FONTTEST_FONT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace fonttest {
+
+class Font;
+class FontEngine;
+
+// Keeps recently used fonts of one FontEngine alive, so that rendering
+// many testcases with the same font file parses it only once. Entries
+// are keyed by path and face index, and are reloaded when the file's
+// modification time or size has changed. Not thread-safe; every thread
+// owns its own engine, and therefore its own cache.
+class FontCache {
+ public:
+  struct Stats {
+    Stats() : hits(0), misses(0), evictions(0) {}
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+  };
+
+  static const size_t kDefaultCapacity = 32;
+
+  FontCache(FontEngine* engine);
+  ~FontCache();
+
+  // Returns the requested font, or an empty pointer if it cannot be loaded.
+  // The returned font stays valid even if it gets evicted from the cache.
+  std::shared_ptr<Font> Get(const std::string& path, int faceIndex);
+
+  void SetCapacity(size_t capacity);
+  size_t GetSize() const { return entries_.size(); }
+  const Stats& GetStats() const { return stats_; }
+  void Clear();
+
+ private:
+  struct Entry {
+    std::string key;
+    int64_t mtime;
+    int64_t fileSize;
+    std::shared_ptr<Font> font;
+  };
+  typedef std::list<Entry> EntryList;
+
+  void EvictToCapacity();
+
+  FontEngine* engine_;
+  size_t capacity_;
+  EntryList entries_;  // most recently used first
+  std::map<std::string, EntryList::iterator> index_;
+  std::string key_;
+  Stats stats_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_FONT_CACHE_H_
@@ -13,6 +13,8 @@
  * limitations under the License.
  */
 
+#include "fonttest/font.h"
+#include "fonttest/font_cache.h"
 #include "fonttest/font_engine.h"
 #include "fonttest/freestack_engine.h"
 #include "fonttest/tehreerstack_engine.h"
@@ -28,6 +30,10 @@ FontEngine* FontEngine::Create(const std::string& engineName) {
     return new FreeStackEngine();
   }
 
+  if (engineName == "FreeStackHB") {
+    return new FreeStackEngine(false);
+  }
+
   if (engineName == "TehreerStack") {
     return new TehreerStackEngine();
   }
@@ -47,7 +53,16 @@ FontEngine* FontEngine::Create(const std::string& engineName) {
   return NULL;
 }
 
+FontEngine::FontEngine()
+  : fontCache_(new FontCache(this)) {
+}
+
 FontEngine::~FontEngine() {
 }
 
+std::shared_ptr<Font> FontEngine::GetCachedFont(const std::string& path,
+                                                int faceIndex) {
+  return fontCache_->Get(path, faceIndex);
+}
+
 }  // namespace fonttest
@@ -17,27 +17,69 @@
 #define FONTTEST_FONT_ENGINE_H_
 
 #include <map>
+#include <memory>
 #include <string>
 
 namespace fonttest {
 class Font;
+class FontCache;
+class FreeTypeMemory;
+class OutlineCache;
+struct InstanceCacheStats;
+struct GlyphRun;
 typedef std::map<std::string, double> FontVariation;  // "WGHT" -> 400.0
 
 class FontEngine {
  public:
+  FontEngine();
   virtual ~FontEngine();
   static FontEngine* Create(const std::string& engineName);
   virtual std::string GetName() const = 0;
   virtual std::string GetVersion() const = 0;
   virtual Font* LoadFont(const std::string& path, int faceIndex) = 0;
 
-  // Renders a line of text into an SVG document.
+  // Like LoadFont(), but shares fonts across calls through the engine's
+  // font cache. Returns an empty pointer if the font cannot be loaded.
+  std::shared_ptr<Font> GetCachedFont(const std::string& path, int faceIndex);
+  FontCache* GetFontCache() { return fontCache_.get(); }
+
+  // Returns the engine's cache of converted glyph outlines, or NULL
+  // for engines that do not have one.
+  virtual OutlineCache* GetOutlineCache() { return NULL; }
+
+  // Returns the allocator of the engine's FreeType library, or NULL
+  // for engines that do not use FreeType.
+  virtual FreeTypeMemory* GetFreeTypeMemory() { return NULL; }
+
+  // Returns the counts of the per-font caches of shaping objects, or
+  // NULL for engines that do not have any.
+  virtual const InstanceCacheStats* GetInstanceCacheStats() const {
+    return NULL;
+  }
+
+  // Renders a line of text into an SVG document. Returns false if the
+  // text cannot be rendered with |font|; the engine stays usable.
   virtual bool RenderSVG(const std::string& text,
                          const std::string& textLanguage,
                          Font* font, double fontSize,
                          const FontVariation& fontVariation,
                          const std::string& id_prefix,
                          std::string* svg) = 0;
+
+  // Shapes a line of text without serializing it. If |withOutlines|
+  // is set, the outlines of all distinct glyphs are added to |run|.
+  // Returns false if rendering fails, like RenderSVG(); engines that
+  // cannot provide glyph runs always return false.
+  virtual bool RenderGlyphs(const std::string& text,
+                            const std::string& textLanguage,
+                            Font* font, double fontSize,
+                            const FontVariation& fontVariation,
+                            bool withOutlines, GlyphRun* run) {
+    return false;
+  }
+
+ private:
+  std::unique_ptr<FontCache> fontCache_;
 };
 
 }  // namespace fonttest
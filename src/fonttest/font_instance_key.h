@@ -0,0 +1,80 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_FONT_INSTANCE_KEY_H_
+#define FONTTEST_FONT_INSTANCE_KEY_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace fonttest {
+
+// Identifies one instance of a font: the font itself, the size at which
+// its outlines are scaled, and its normalized variation coordinates.
+// Caches that depend on the instance use this as (part of) their key.
+// The hash is precomputed by UpdateHash(), so comparing two keys that
+// differ is usually a single integer comparison.
+struct FontInstanceKey {
+  FontInstanceKey() : fontID(0), size(0), hash(0) {}
+
+  void UpdateHash() {
+    uint64_t h = 14695981039346656037ULL;  // FNV-1a
+    Mix(&h, fontID);
+    Mix(&h, static_cast<uint64_t>(size));
+    for (int64_t coord : coords) {
+      Mix(&h, static_cast<uint64_t>(coord));
+    }
+    hash = h;
+  }
+
+  bool operator==(const FontInstanceKey& other) const {
+    return hash == other.hash && fontID == other.fontID &&
+        size == other.size && coords == other.coords;
+  }
+
+  bool operator!=(const FontInstanceKey& other) const {
+    return !(*this == other);
+  }
+
+  bool operator<(const FontInstanceKey& other) const {
+    if (hash != other.hash) {
+      return hash < other.hash;
+    }
+    if (fontID != other.fontID) {
+      return fontID < other.fontID;
+    }
+    if (size != other.size) {
+      return size < other.size;
+    }
+    return coords < other.coords;
+  }
+
+  uint64_t fontID;
+  int64_t size;                 // 26.6 fixed point
+  std::vector<int64_t> coords;  // 16.16 fixed point, normalized
+  uint64_t hash;
+
+ private:
+  static void Mix(uint64_t* h, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+      *h ^= (value >> (i * 8)) & 0xff;
+      *h *= 1099511628211ULL;
+    }
+  }
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_FONT_INSTANCE_KEY_H_
@@ -18,11 +18,17 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 
+#include "fonttest/font_cache.h"
 #include "fonttest/font_engine.h"
 #include "fonttest/freestack_engine.h"
 #include "fonttest/freestack_font.h"
+#include "fonttest/freestack_path.h"
 #include "fonttest/freestack_line.h"
+#include "fonttest/harfbuzz_line.h"
+#include "fonttest/perf_counters.h"
+#include "fonttest/trace.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -32,16 +38,20 @@
 
 namespace fonttest {
 
-FreeStackEngine::FreeStackEngine() {
-  FT_Init_FreeType(&freeTypeLibrary_);
+FreeStackEngine::FreeStackEngine(bool useRaqm)
+  : useRaqm_(useRaqm) {
+  freeTypeMemory_.NewLibrary(&freeTypeLibrary_);
 }
 
 FreeStackEngine::~FreeStackEngine() {
-  FT_Done_FreeType(freeTypeLibrary_);
+  // Cached faces belong to our FreeType library, so they must be
+  // released before the library itself goes away.
+  GetFontCache()->Clear();
+  FT_Done_Library(freeTypeLibrary_);
 }
 
 std::string FreeStackEngine::GetName() const {
-  return "FreeStack";
+  return useRaqm_ ? "FreeStack" : "FreeStackHB";
 }
 
 std::string FreeStackEngine::GetVersion() const {
@@ -56,14 +66,18 @@ std::string FreeStackEngine::GetVersion() const {
   result << " FriBidi/" << FRIBIDI_MAJOR_VERSION << '.'
 	 << FRIBIDI_MINOR_VERSION << '.' << FRIBIDI_MICRO_VERSION;
 
-  result << " Raqm/" << RAQM_VERSION_MAJOR << '.'
-	 << RAQM_VERSION_MINOR << '.' << RAQM_VERSION_MICRO;
+  if (useRaqm_) {
+    result << " Raqm/" << RAQM_VERSION_MAJOR << '.'
+           << RAQM_VERSION_MINOR << '.' << RAQM_VERSION_MICRO;
+  }
 
   return result.str();
 }
 
 Font* FreeStackEngine::LoadFont(
     const std::string& path, int faceIndex) {
+  TraceSpan span("FreeStackEngine::LoadFont");
+  PerfScope perf(kPerfStageLoadFont);
   FT_Face face = NULL;
   FT_Error error = FT_New_Face(freeTypeLibrary_, path.c_str(),
 			       static_cast<FT_Long>(faceIndex), &face);
@@ -71,7 +85,7 @@ Font* FreeStackEngine::LoadFont(
     return NULL;
   }
 
-  return new FreeStackFont(face);
+  return new FreeStackFont(face, &outlineCache_, &instanceCacheStats_);
 }
 
 bool FreeStackEngine::RenderSVG(const std::string& text,
@@ -80,10 +94,48 @@ bool FreeStackEngine::RenderSVG(const std::string& text,
                                 const FontVariation& fontVariation,
                                 const std::string& idPrefix,
                                 std::string* svg) {
-  FT_Face face =
-      static_cast<FreeStackFont*>(font)->GetFace(fontSize, fontVariation);
-  FreeStackLine line(text, textLanguage, face, fontSize);
-  return line.RenderSVG(idPrefix, svg);
+  TraceSpan span("FreeStackEngine::RenderSVG");
+  FreeStackFont* freeStackFont = static_cast<FreeStackFont*>(font);
+  FT_Face face = freeStackFont->GetFace(fontSize, fontVariation);
+  if (!face ||
+      !Shape(text, textLanguage, freeStackFont, face, fontSize, &glyphRun_)) {
+    return false;
+  }
+  return svgEmitter_.Emit(glyphRun_, face, fontSize, idPrefix, &outlineCache_,
+                          outlineCache_.GetInstance(
+                              freeStackFont->GetInstanceKey()), svg);
+}
+
+bool FreeStackEngine::RenderGlyphs(const std::string& text,
+                                   const std::string& textLanguage,
+                                   Font* font, double fontSize,
+                                   const FontVariation& fontVariation,
+                                   bool withOutlines, GlyphRun* run) {
+  TraceSpan span("FreeStackEngine::RenderGlyphs");
+  FreeStackFont* freeStackFont = static_cast<FreeStackFont*>(font);
+  FT_Face face = freeStackFont->GetFace(fontSize, fontVariation);
+  if (!face || !Shape(text, textLanguage, freeStackFont, face, fontSize, run)) {
+    return false;
+  }
+  if (withOutlines) {
+    return AddGlyphRunOutlines(face, &outlineCache_,
+                               outlineCache_.GetInstance(
+                                   freeStackFont->GetInstanceKey()), run);
+  }
+  return true;
+}
+
+bool FreeStackEngine::Shape(const std::string& text,
+                            const std::string& textLanguage,
+                            FreeStackFont* font, FT_Face face,
+                            double fontSize, GlyphRun* run) {
+  if (useRaqm_) {
+    FreeStackLine line(text, textLanguage, face, fontSize);
+    return line.GetGlyphRun(run);
+  } else {
+    HarfBuzzLine line(text, textLanguage, font->GetHarfBuzzInstance());
+    return line.GetGlyphRun(run);
+  }
 }
 
 }  // namespace fonttest
@@ -26,16 +26,31 @@
 #include FT_TYPES_H
 
 #include "fonttest/font.h"
+#include "fonttest/freetype_memory.h"
+#include "fonttest/glyph_run.h"
+#include "fonttest/instance_cache.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/svg_emitter.h"
 
 namespace fonttest {
 
+class FreeStackFont;
+
 class FreeStackEngine : public FontEngine {
  public:
-  FreeStackEngine();
+  // Lines are laid out by Raqm, or with |useRaqm| false, by HarfBuzzLine,
+  // which keeps HarfBuzz fonts and shape plans from line to line. The
+  // latter engine is called FreeStackHB.
+  explicit FreeStackEngine(bool useRaqm = true);
   ~FreeStackEngine();
   virtual std::string GetName() const;
   virtual std::string GetVersion() const;
   virtual Font* LoadFont(const std::string& path, int faceIndex);
+  virtual OutlineCache* GetOutlineCache() { return &outlineCache_; }
+  virtual FreeTypeMemory* GetFreeTypeMemory() { return &freeTypeMemory_; }
+  virtual const InstanceCacheStats* GetInstanceCacheStats() const {
+    return &instanceCacheStats_;
+  }
 
   // Renders a line of text into an SVG document.
   virtual bool RenderSVG(const std::string& text,
@@ -45,8 +60,24 @@ class FreeStackEngine : public FontEngine {
                          const std::string& idPrefix,
                          std::string* svg);
 
+  virtual bool RenderGlyphs(const std::string& text,
+                            const std::string& textLanguage,
+                            Font* font, double fontSize,
+                            const FontVariation& fontVariation,
+                            bool withOutlines, GlyphRun* run);
+
  private:
+  bool Shape(const std::string& text, const std::string& textLanguage,
+             FreeStackFont* font, FT_Face face, double fontSize,
+             GlyphRun* run);
+
+  const bool useRaqm_;
+  FreeTypeMemory freeTypeMemory_;
   FT_Library freeTypeLibrary_;
+  OutlineCache outlineCache_;
+  InstanceCacheStats instanceCacheStats_;
+  GlyphRun glyphRun_;
+  SVGEmitter svgEmitter_;
 };
 
 }  // namespace fonttest
@@ -13,11 +13,13 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include <ft2build.h>
 #include FT_MULTIPLE_MASTERS_H
@@ -25,17 +27,13 @@
 #include "fonttest/font.h"
 #include "fonttest/freestack_font.h"
 #include "fonttest/freestack_path.h"
+#include "fonttest/harfbuzz_line.h"
+#include "fonttest/perf_counters.h"
+#include "fonttest/tehreerstack_line.h"
+#include "fonttest/trace.h"
 
 namespace fonttest {
 
-FreeStackFont::FreeStackFont(FT_Face face)
-  : face_(face) {
-}
-
-FreeStackFont::~FreeStackFont() {
-  FT_Done_Face(face_);
-}
-
 static std::string TagToString(FT_ULong tag) {
   char s[5];
   s[0] = static_cast<char>((tag & 0xff000000) >> 24);
@@ -55,61 +53,154 @@ static std::string TagToString(FT_ULong tag) {
   return std::string(s);
 }
 
+static std::atomic<uint64_t> nextFontID(1);
+
+FreeStackFont::FreeStackFont(FT_Face face, OutlineCache* outlineCache,
+                             InstanceCacheStats* instanceStats,
+                             const std::shared_ptr<const SfntFile>& sfntFile)
+  : face_(face), outlineCache_(outlineCache), sfntFile_(sfntFile),
+    mmvar_(NULL),
+    hasSize_(false), size_(0),
+    harfBuzzInstances_(kMaxHarfBuzzInstances, instanceStats),
+    sheenFigureInstances_(kMaxSheenFigureInstances, instanceStats) {
+  instanceKey_.fontID = nextFontID++;
+  if (FT_Get_MM_Var(face_, &mmvar_) || !mmvar_) {
+    mmvar_ = NULL;
+  } else {
+    for (FT_UInt axisIndex = 0; axisIndex < mmvar_->num_axis; ++axisIndex) {
+      axisTags_.push_back(TagToString(mmvar_->axis[axisIndex].tag));
+    }
+  }
+  UpdateInstanceKey();
+}
+
+FreeStackFont::~FreeStackFont() {
+  // HarfBuzz and SheenFigure fonts hold a reference to the face.
+  harfBuzzInstances_.Clear();
+  sheenFigureInstances_.Clear();
+  if (mmvar_) {
+    FT_Done_MM_Var(face_->glyph->library, mmvar_);
+  }
+  FT_Done_Face(face_);
+}
+
 FT_Face FreeStackFont::GetFace(double size, const FontVariation& variation) {
-  FT_Fixed fixedSize = static_cast<FT_Fixed>(size * 64 + 0.5);
-  FT_Error error = FT_Set_Char_Size(face_, fixedSize, fixedSize, 0, 0);
-  if (error) {
-    std::cerr << "FT_Set_Char_Size() failed; error: " << error << std::endl;
-    exit(1);
+  TraceSpan span("FreeStackFont::GetFace");
+  PerfScope perf(kPerfStageVariation);
+  bool changed = false;
+  FT_F26Dot6 fixedSize = static_cast<FT_F26Dot6>(size * 64 + 0.5);
+  if (!hasSize_ || fixedSize != size_) {
+    FT_Error error = FT_Set_Char_Size(face_, fixedSize, fixedSize, 0, 0);
+    if (error) {
+      std::cerr << "FT_Set_Char_Size() failed; error: " << error << std::endl;
+      hasSize_ = false;
+      return NULL;
+    }
+    hasSize_ = true;
+    size_ = fixedSize;
+    changed = true;
   }
 
-  FT_MM_Var* mmvar = NULL;
-  FT_Get_MM_Var(face_, &mmvar);
-  if (mmvar) {
-    FT_Fixed coords[mmvar->num_axis];
-    for (FT_UInt axisIndex = 0; axisIndex < mmvar->num_axis; ++axisIndex) {
-      const FT_Var_Axis& axis = mmvar->axis[axisIndex];
-      coords[axisIndex] = axis.def;
+  if (mmvar_) {
+    requestedCoords_.resize(mmvar_->num_axis);
+    for (FT_UInt axisIndex = 0; axisIndex < mmvar_->num_axis; ++axisIndex) {
+      requestedCoords_[axisIndex] = mmvar_->axis[axisIndex].def;
       FontVariation::const_iterator iter =
-          variation.find(TagToString(axis.tag));
+          variation.find(axisTags_[axisIndex]);
       if (iter != variation.end()) {
-        coords[axisIndex] =
+        requestedCoords_[axisIndex] =
           static_cast<FT_Fixed>(iter->second * 65536.0 + 0.5);
       }
     }
-    error = FT_Set_Var_Design_Coordinates(face_, mmvar->num_axis, coords);
-    if (error) {
-      std::cerr << "FT_Set_Var_Design_Coordinates() failed; error: "
-                << error << std::endl;
-      exit(1);
+    if (requestedCoords_ != designCoords_) {
+      FT_Error error = FT_Set_Var_Design_Coordinates(
+          face_, mmvar_->num_axis, &requestedCoords_[0]);
+      if (error) {
+        std::cerr << "FT_Set_Var_Design_Coordinates() failed; error: "
+                  << error << std::endl;
+        // The variation is now unknown; set it again on the next call.
+        designCoords_.clear();
+        UpdateInstanceKey();
+        return NULL;
+      }
+      designCoords_.swap(requestedCoords_);
+      changed = true;
     }
-    free(static_cast<void*>(mmvar));
   }
 
+  if (changed) {
+    UpdateInstanceKey();
+  }
   return face_;
 }
 
+HarfBuzzInstance* FreeStackFont::GetHarfBuzzInstance() {
+  HarfBuzzInstance* instance = harfBuzzInstances_.Find(instanceKey_);
+  if (!instance) {
+    TraceSpan span("FreeStackFont::GetHarfBuzzInstance");
+    instance = harfBuzzInstances_.Insert(
+        instanceKey_,
+        std::unique_ptr<HarfBuzzInstance>(new HarfBuzzInstance(face_)));
+  }
+  return instance;
+}
+
+SheenFigureInstance* FreeStackFont::GetSheenFigureInstance() {
+  SheenFigureInstance* instance =
+      sheenFigureInstances_.Find(instanceKey_.coords);
+  if (!instance) {
+    TraceSpan span("FreeStackFont::GetSheenFigureInstance");
+    instance = sheenFigureInstances_.Insert(
+        instanceKey_.coords,
+        std::unique_ptr<SheenFigureInstance>(
+            new SheenFigureInstance(face_, sfntFile_)));
+  }
+  return instance;
+}
+
+void FreeStackFont::UpdateInstanceKey() {
+  instanceKey_.size = size_;
+  instanceKey_.coords.clear();
+  if (mmvar_ && mmvar_->num_axis > 0) {
+    blendCoords_.resize(mmvar_->num_axis);
+    if (!FT_Get_Var_Blend_Coordinates(face_, mmvar_->num_axis,
+                                      &blendCoords_[0])) {
+      instanceKey_.coords.assign(blendCoords_.begin(), blendCoords_.end());
+    }
+  }
+  instanceKey_.UpdateHash();
+}
+
 void FreeStackFont::GetGlyphOutline(int glyphID,
                                     const FontVariation& variation,
                                     std::string* path,
                                     std::string* viewBox) {
+  path->clear();
+  viewBox->clear();
   FT_Face face = GetFace(1000.0, variation);
+  if (!face) {
+    return;
+  }
+  OutlineCache::Instance* instance = NULL;
+  if (outlineCache_) {
+    instance = outlineCache_->GetInstance(instanceKey_);
+  }
+
+  if (!AppendGlyphPath(face, glyphID, outlineCache_, instance, path)) {
+    path->clear();
+    return;
+  }
+
+  // The advance is only known after the glyph has been loaded; on a cache
+  // hit, AppendGlyphPath() did not need to.
   FT_Error error =
       FT_Load_Glyph(face, glyphID, FT_LOAD_NO_HINTING|FT_LOAD_NO_BITMAP);
   if (error) {
     std::cerr << "FT_Load_Glyph() failed; error: " << error << std::endl;
-    exit(1);
-  }
-
-  if (!face->glyph) {
-    std::cerr << "FT_Load_Glyph() did not load a glyph" << std::endl;
-    exit(1);
+    path->clear();
+    return;
   }
 
-  FT_Vector transform;
-  transform.x = transform.y = 0;
-  FreeTypePathConverter converter(transform);
-  path->assign(converter.Convert(&face->glyph->outline));
   char buffer[200];
   snprintf(buffer, sizeof(buffer), "%ld %ld %ld %ld",
            0L, lround(face->descender),
@@ -16,24 +16,86 @@
 #ifndef FONTTEST_FREESTACK_FONT_H_
 #define FONTTEST_FREESTACK_FONT_H_
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MULTIPLE_MASTERS_H
 #include FT_TYPES_H
 
 #include "fonttest/font.h"
+#include "fonttest/font_instance_key.h"
+#include "fonttest/instance_cache.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/sfnt_file.h"
 
 namespace fonttest {
 
+class HarfBuzzInstance;
+class SheenFigureInstance;
+
 class FreeStackFont : public Font {
  public:
-  FreeStackFont(FT_Face face);
+  // |outlineCache| and |instanceStats| may be NULL; otherwise, they
+  // must outlive the font. |sfntFile|, the mapped font file of |face|,
+  // may be NULL as well.
+  FreeStackFont(FT_Face face, OutlineCache* outlineCache,
+                InstanceCacheStats* instanceStats,
+                const std::shared_ptr<const SfntFile>& sfntFile =
+                    std::shared_ptr<const SfntFile>());
   ~FreeStackFont();
+
+  // Returns the face, set up for the requested size and variation, or
+  // NULL if FreeType cannot set it up; for example, bitmap-only fonts
+  // have no scalable sizes. FreeType is only called when the size or
+  // variation differ from the previous call.
   FT_Face GetFace(double size, const FontVariation& variation);
   virtual void GetGlyphOutline(int glyphID, const FontVariation& variation,
                                std::string* path, std::string* viewBox);
 
+  // Describes the instance that was selected by the last call to GetFace().
+  const FontInstanceKey& GetInstanceKey() const { return instanceKey_; }
+
+  // Returns the HarfBuzz font and shape plans for the instance that was
+  // selected by the last call to GetFace(), creating them on first use.
+  // Only the most recently used instances are kept; the returned pointer
+  // stays valid until the next call.
+  HarfBuzzInstance* GetHarfBuzzInstance();
+
+  // Returns the SheenFigure font and patterns for the variation selected
+  // by the last call to GetFace(), creating them on first use. Unlike
+  // HarfBuzz fonts, these are shared between sizes. As with those, only
+  // the most recently used ones are kept.
+  SheenFigureInstance* GetSheenFigureInstance();
+
  private:
+  static const size_t kMaxHarfBuzzInstances = 8;
+  static const size_t kMaxSheenFigureInstances = 8;
+
+  void UpdateInstanceKey();
+
   FT_Face face_;
+  OutlineCache* outlineCache_;
+  std::shared_ptr<const SfntFile> sfntFile_;
+
+  // Variation axes, parsed once; NULL for non-variable fonts.
+  FT_MM_Var* mmvar_;
+  std::vector<std::string> axisTags_;
+
+  // The currently applied instance.
+  bool hasSize_;
+  FT_F26Dot6 size_;
+  std::vector<FT_Fixed> designCoords_;
+  std::vector<FT_Fixed> requestedCoords_;  // scratch space for GetFace()
+  std::vector<FT_Fixed> blendCoords_;  // scratch for UpdateInstanceKey()
+  FontInstanceKey instanceKey_;
+
+  InstanceCache<FontInstanceKey, HarfBuzzInstance> harfBuzzInstances_;
+  InstanceCache<std::vector<int64_t>, SheenFigureInstance>
+      sheenFigureInstances_;  // by normalized variation coordinates
 };
 
 }  // namespace fonttest
@@ -22,6 +22,7 @@
 #include "raqm.h"
 
 #include "fonttest/font.h"
+#include "fonttest/glyph_run.h"
 
 namespace fonttest {
 
@@ -30,12 +31,20 @@ class FreeStackLine {
   FreeStackLine(const std::string& text, const std::string& textLanguage,
                 FT_Face font, double fontSize);
   ~FreeStackLine();
-  bool RenderSVG(const std::string& idPrefix, std::string* svg);
+
+  // Replaces the contents of |run| by the shaped glyphs of this line.
+  // Returns false, with |run| empty, if the line could not be shaped.
+  bool GetGlyphRun(GlyphRun* run) const;
 
  private:
+  FreeStackLine(const FreeStackLine&);
+  void operator=(const FreeStackLine&);
+
+  // The raqm_t that the thread's lines share, so that Raqm reuses its
+  // buffers; or a line of our own, if another line on the same thread
+  // is still holding the shared one.
   raqm_t* line_;
-  FT_Face font_;
-  double fontSize_;
+  bool ok_;
 };
 
 }  // namespace fonttest
@@ -14,27 +14,87 @@
  */
 
 #include <cstdlib>
-#include <cstdio>
 #include <iostream>
 #include <string>
+#include <unordered_set>
 
 #include <ft2build.h>
+#include FT_FREETYPE_H
 #include FT_IMAGE_H
 #include FT_OUTLINE_H
 
 #include "fonttest/freestack_path.h"
+#include "fonttest/perf_counters.h"
 
 namespace fonttest {
 
+bool AppendGlyphPath(FT_Face face, FT_UInt glyphID,
+                     OutlineCache* cache, OutlineCache::Instance* instance,
+                     std::string* path) {
+  if (cache && instance) {
+    const std::string* cached = cache->Find(instance, glyphID);
+    if (cached) {
+      path->append(*cached);
+      return true;
+    }
+  }
+
+  PerfScope perf(kPerfStageOutlines);
+  FT_Error error =
+      FT_Load_Glyph(face, glyphID, FT_LOAD_NO_HINTING|FT_LOAD_NO_BITMAP);
+  if (error) {
+    std::cerr << "FT_Load_Glyph() failed; error: " << error << std::endl;
+    return false;
+  }
+
+  if (!face->glyph) {
+    std::cerr << "FT_Load_Glyph() did not load a glyph" << std::endl;
+    return false;
+  }
+
+  FT_Vector transform;
+  transform.x = transform.y = 0;
+  FreeTypePathConverter converter(transform);
+  const size_t start = path->size();
+  if (!converter.Convert(&face->glyph->outline, path)) {
+    path->resize(start);
+    return false;
+  }
+  if (cache && instance) {
+    cache->Insert(instance, glyphID, path->substr(start));
+  }
+  return true;
+}
+
+bool AddGlyphRunOutlines(FT_Face face,
+                         OutlineCache* cache, OutlineCache::Instance* instance,
+                         GlyphRun* run) {
+  std::unordered_set<uint32_t> seen;
+  for (uint32_t glyphID : run->glyphIDs) {
+    if (!seen.insert(glyphID).second) {
+      continue;
+    }
+    run->outlineGlyphIDs.push_back(glyphID);
+    run->outlines.push_back(std::string());
+    if (!AppendGlyphPath(face, glyphID, cache, instance,
+                         &run->outlines.back())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 FreeTypePathConverter::FreeTypePathConverter(const FT_Vector& transform)
-  : transform_(transform) {
+  : writer_(NULL), transform_(transform) {
 }
 
 FreeTypePathConverter::~FreeTypePathConverter() {
 }
 
-std::string FreeTypePathConverter::Convert(FT_Outline* outline) {
-  path_.clear();
+bool FreeTypePathConverter::Convert(FT_Outline* outline,
+                                    std::string* path) {
+  SVGPathWriter writer(path);
+  writer_ = &writer;
   start_.x = start_.y = 0;
   closed_ = true;
 
@@ -47,27 +107,27 @@ std::string FreeTypePathConverter::Convert(FT_Outline* outline) {
   callbacks.delta = 0;
   FT_Error error =
       FT_Outline_Decompose(outline, &callbacks, static_cast<void*>(this));
+  writer_ = NULL;
   if (error) {
     std::cerr << "FT_Outline_Decompose() failed; error: " << error
 	      << std::endl;
-    exit(1);
+    return false;
   }
   if (!closed_) {
-    path_.append(" Z");
+    writer.ClosePath();
   }
-  return path_;
+  return true;
 }
 
+// Coordinates are truncated towards zero, as the division of
+// 26.6 fixed-point values by 64 always did.
 void FreeTypePathConverter::MoveTo(const FT_Vector& to) {
   start_.x = to.x + transform_.x;
   start_.y = to.y + transform_.y;
   if (!closed_) {
-    path_.append(" Z");
+    writer_->ClosePath();
   }
-  char buffer[200];
-  snprintf(buffer, sizeof(buffer), "%sM%ld,%ld",
-           path_.empty() ? "" : " ", start_.x / 64, start_.y / 64);
-  path_.append(buffer);
+  writer_->MoveTo(start_.x / 64, start_.y / 64);
   closed_ = false;
 }
 
@@ -76,42 +136,33 @@ void FreeTypePathConverter::LineTo(const FT_Vector& to) {
   p.x = to.x + transform_.x;
   p.y = to.y + transform_.y;
   if (p.x == start_.x && p.y == start_.y) {
-    path_.append(" Z");
+    writer_->ClosePath();
     closed_ = true;
     return;
   }
-  char buffer[200];
-  snprintf(buffer, sizeof(buffer), "%sL%ld,%ld",
-           path_.empty() ? "" : " ", p.x / 64, p.y / 64);
-  path_.append(buffer);
+  writer_->LineTo(p.x / 64, p.y / 64);
   closed_ = false;
 }
 
 void FreeTypePathConverter::QuadTo(const FT_Vector& control,
                                    const FT_Vector& to) {
-  char buffer[200];
-  snprintf(buffer, sizeof(buffer), "%sQ%ld,%ld %ld,%ld",
-           path_.empty() ? "" : " ",
-	   (control.x + transform_.x) / 64, (control.y + transform_.y) / 64,
-           (to.x + transform_.x) / 64, (to.y + transform_.y) / 64);
-  path_.append(buffer);
+  writer_->QuadTo((control.x + transform_.x) / 64,
+                  (control.y + transform_.y) / 64,
+                  (to.x + transform_.x) / 64, (to.y + transform_.y) / 64);
   closed_ = false;
 }
 
 void FreeTypePathConverter::CurveTo(const FT_Vector& control1,
                                     const FT_Vector& control2,
                                     const FT_Vector& to) {
-  char buffer[200];
-  snprintf(buffer, sizeof(buffer), "%sC%ld,%ld %ld,%ld %ld,%ld",
-           path_.empty() ? "" : " ",
-           (control1.x + transform_.x) / 64, (control1.y + transform_.y) / 64,
-           (control2.x + transform_.x) / 64, (control2.y + transform_.y) / 64,
-           (to.x + transform_.x) / 64, (to.y + transform_.y) / 64);
-  path_.append(buffer);
+  writer_->CurveTo((control1.x + transform_.x) / 64,
+                   (control1.y + transform_.y) / 64,
+                   (control2.x + transform_.x) / 64,
+                   (control2.y + transform_.y) / 64,
+                   (to.x + transform_.x) / 64, (to.y + transform_.y) / 64);
   closed_ = false;
 }
 
-
 int FreeTypePathConverter::MoveToCallback(const FT_Vector* to, void* data) {
   if (to && data) {
     reinterpret_cast<FreeTypePathConverter*>(data)->MoveTo(*to);
@@ -19,16 +19,37 @@
 #include <string>
 
 #include <ft2build.h>
+#include FT_FREETYPE_H
 #include FT_IMAGE_H
 #include FT_TYPES_H
 
+#include "fonttest/glyph_run.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/svg_path_writer.h"
+
 namespace fonttest {
 
+// Appends the outline of a glyph, in SVG path format, to |path|.
+// Outlines are taken from |cache| when possible; on a cache miss,
+// the glyph gets loaded into |face| and converted. Returns false if
+// the glyph cannot be loaded or converted.
+bool AppendGlyphPath(FT_Face face, FT_UInt glyphID,
+                     OutlineCache* cache, OutlineCache::Instance* instance,
+                     std::string* path);
+
+// Fills in the outlines of every distinct glyph in |run|.
+bool AddGlyphRunOutlines(FT_Face face,
+                         OutlineCache* cache, OutlineCache::Instance* instance,
+                         GlyphRun* run);
+
 class FreeTypePathConverter {
  public:
   FreeTypePathConverter(const FT_Vector& transform);
   ~FreeTypePathConverter();
-  std::string Convert(FT_Outline* outline);
+
+  // Appends the outline, in SVG path format, to |path|. Returns false
+  // if FreeType cannot decompose the outline.
+  bool Convert(FT_Outline* outline, std::string* path);
 
  private:
   void MoveTo(const FT_Vector& to);
@@ -45,7 +66,7 @@ class FreeTypePathConverter {
                              const FT_Vector* control2,
                              const FT_Vector* to, void* data);
 
-  std::string path_;
+  SVGPathWriter* writer_;  // only set during Convert()
   FT_Vector start_, transform_;
   bool closed_;
 };
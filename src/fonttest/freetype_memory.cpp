@@ -0,0 +1,140 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MODULE_H
+#include FT_SYSTEM_H
+
+#include "fonttest/freetype_memory.h"
+
+namespace fonttest {
+
+// FreeType does not pass the size of a block to Free(), so every block
+// is prefixed by a header that remembers it. The header is as large as
+// the strictest alignment, so blocks stay aligned for FreeType.
+union BlockHeader {
+  size_t size;
+  std::max_align_t align;
+};
+
+static inline BlockHeader* GetHeader(void* block) {
+  return static_cast<BlockHeader*>(block) - 1;
+}
+
+FreeTypeMemory::FreeTypeMemory() {
+  memory_.user = this;
+  memory_.alloc = &FreeTypeMemory::Alloc;
+  memory_.free = &FreeTypeMemory::Free;
+  memory_.realloc = &FreeTypeMemory::Realloc;
+}
+
+FreeTypeMemory::~FreeTypeMemory() {
+}
+
+FT_Error FreeTypeMemory::NewLibrary(FT_Library* library) {
+  FT_Error error = FT_New_Library(&memory_, library);
+  if (error) {
+    return error;
+  }
+  FT_Add_Default_Modules(*library);
+  FT_Set_Default_Properties(*library);
+  return 0;
+}
+
+void FreeTypeMemory::Allocated(size_t size) {
+  stats_.bytes += size;
+  ++stats_.allocations;
+  if (stats_.bytes > stats_.peakBytes) {
+    stats_.peakBytes = stats_.bytes;
+  }
+  if (stats_.bytes > stats_.recentPeakBytes) {
+    stats_.recentPeakBytes = stats_.bytes;
+  }
+}
+
+void* FreeTypeMemory::Alloc(FT_Memory memory, long size) {
+  FreeTypeMemory* self = static_cast<FreeTypeMemory*>(memory->user);
+  BlockHeader* header = static_cast<BlockHeader*>(
+      malloc(sizeof(BlockHeader) + static_cast<size_t>(size)));
+  if (!header) {
+    return NULL;
+  }
+  header->size = static_cast<size_t>(size);
+  self->Allocated(header->size);
+  return header + 1;
+}
+
+void FreeTypeMemory::Free(FT_Memory memory, void* block) {
+  if (!block) {
+    return;
+  }
+  FreeTypeMemory* self = static_cast<FreeTypeMemory*>(memory->user);
+  BlockHeader* header = GetHeader(block);
+  self->stats_.bytes -= header->size;
+  ++self->stats_.frees;
+  free(header);
+}
+
+void* FreeTypeMemory::Realloc(FT_Memory memory, long currentSize,
+                              long newSize, void* block) {
+  if (!block) {
+    return Alloc(memory, newSize);
+  }
+  FreeTypeMemory* self = static_cast<FreeTypeMemory*>(memory->user);
+  const size_t oldSize = GetHeader(block)->size;
+  BlockHeader* header = static_cast<BlockHeader*>(
+      realloc(GetHeader(block),
+              sizeof(BlockHeader) + static_cast<size_t>(newSize)));
+  if (!header) {
+    return NULL;  // FreeType keeps the old block
+  }
+  header->size = static_cast<size_t>(newSize);
+  self->stats_.bytes -= oldSize;
+  self->Allocated(header->size);
+  return header + 1;
+}
+
+void PrintFreeTypeMemoryUsage(const std::string& id,
+                              const FreeTypeMemory::Stats& beforeLoad,
+                              const FreeTypeMemory::Stats& beforeRender,
+                              const FreeTypeMemory::Stats& after,
+                              std::ostream* output) {
+  static std::mutex outputMutex;
+  std::lock_guard<std::mutex> lock(outputMutex);
+  *output << "memstats " << id << ": ";
+  if (beforeRender.allocations == beforeLoad.allocations) {
+    *output << "font cached";
+  } else {
+    *output << "font load "
+            << static_cast<long long>(beforeRender.bytes - beforeLoad.bytes)
+            << " bytes in "
+            << beforeRender.allocations - beforeLoad.allocations
+            << " allocations";
+  }
+  *output << "; render peak "
+          << after.recentPeakBytes - beforeRender.bytes << " bytes in "
+          << after.allocations - beforeRender.allocations << " allocations, "
+          << static_cast<long long>(after.bytes - beforeRender.bytes)
+          << " bytes retained" << std::endl;
+}
+
+}  // namespace fonttest
@@ -0,0 +1,79 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_FREETYPE_MEMORY_H_
+#define FONTTEST_FREETYPE_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_SYSTEM_H
+
+namespace fonttest {
+
+// An FT_Memory that counts the allocations of a FreeType library.
+// Not thread-safe, just like the library that uses it.
+class FreeTypeMemory {
+ public:
+  struct Stats {
+    Stats() : bytes(0), peakBytes(0), recentPeakBytes(0),
+              allocations(0), frees(0) {}
+    size_t bytes;            // currently allocated
+    size_t peakBytes;        // since the library was created
+    size_t recentPeakBytes;  // since the last ResetRecentPeak()
+    uint64_t allocations;    // including reallocations
+    uint64_t frees;
+  };
+
+  FreeTypeMemory();
+  ~FreeTypeMemory();
+
+  // Like FT_Init_FreeType(), but allocating through this object, which
+  // must outlive the library. Release the library with FT_Done_Library().
+  FT_Error NewLibrary(FT_Library* library);
+
+  const Stats& GetStats() const { return stats_; }
+  void ResetRecentPeak() { stats_.recentPeakBytes = stats_.bytes; }
+
+ private:
+  FreeTypeMemory(const FreeTypeMemory&);
+  void operator=(const FreeTypeMemory&);
+
+  static void* Alloc(FT_Memory memory, long size);
+  static void Free(FT_Memory memory, void* block);
+  static void* Realloc(FT_Memory memory, long currentSize, long newSize,
+                       void* block);
+  void Allocated(size_t size);
+
+  FT_MemoryRec_ memory_;
+  Stats stats_;
+};
+
+// Prints a line such as "memstats AVAR-1/1: font load 81234 bytes in
+// 120 allocations; render peak 2345 bytes in 56 allocations, 128 bytes
+// retained". Safe to call from several threads on the same |output|.
+void PrintFreeTypeMemoryUsage(const std::string& id,
+                              const FreeTypeMemory::Stats& beforeLoad,
+                              const FreeTypeMemory::Stats& beforeRender,
+                              const FreeTypeMemory::Stats& after,
+                              std::ostream* output);
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_FREETYPE_MEMORY_H_
@@ -0,0 +1,67 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_GLYPH_RUN_H_
+#define FONTTEST_GLYPH_RUN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fonttest {
+
+// A line of shaped glyphs, as produced by an engine's layout stage and
+// consumed by SVGEmitter. Glyphs are stored as a struct of arrays, in
+// visual order. Positions are integers in a fixed-point unit of the
+// engine's choosing (26.6 pixels for Raqm, font units for SheenFigure);
+// multiplying them by |scale| gives SVG user units.
+struct GlyphRun {
+  GlyphRun() : scale(1.0) {}
+
+  size_t GetSize() const { return glyphIDs.size(); }
+
+  void Clear() {
+    glyphIDs.clear();
+    xOffsets.clear();
+    yOffsets.clear();
+    xAdvances.clear();
+    yAdvances.clear();
+    outlineGlyphIDs.clear();
+    outlines.clear();
+  }
+
+  void Append(uint32_t glyphID, int32_t xOffset, int32_t yOffset,
+              int32_t xAdvance, int32_t yAdvance) {
+    glyphIDs.push_back(glyphID);
+    xOffsets.push_back(xOffset);
+    yOffsets.push_back(yOffset);
+    xAdvances.push_back(xAdvance);
+    yAdvances.push_back(yAdvance);
+  }
+
+  double scale;
+  std::vector<uint32_t> glyphIDs;
+  std::vector<int32_t> xOffsets, yOffsets;
+  std::vector<int32_t> xAdvances, yAdvances;
+
+  // Only filled on request: the SVG path of every distinct glyph.
+  std::vector<uint32_t> outlineGlyphIDs;
+  std::vector<std::string> outlines;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_GLYPH_RUN_H_
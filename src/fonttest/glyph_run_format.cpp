@@ -0,0 +1,143 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "fonttest/glyph_run.h"
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/json.h"
+#include "fonttest/svg_path_writer.h"
+
+namespace fonttest {
+
+bool ParseOutputFormat(const std::string& name, OutputFormat* format) {
+  if (name.empty() || name == "svg") {
+    *format = kFormatSVG;
+  } else if (name == "glyphs") {
+    *format = kFormatGlyphsJSON;
+  } else if (name == "glyphs-binary") {
+    *format = kFormatGlyphsBinary;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+namespace {
+
+// Rounds glyph positions to SVG units, exactly like SVGEmitter does.
+class GlyphPositioner {
+ public:
+  explicit GlyphPositioner(const GlyphRun& run)
+    : run_(run), x_(0), y_(0) {}
+
+  long GetWidth() const {
+    int64_t width = 0;
+    for (size_t i = 0; i < run_.GetSize(); ++i) {
+      width += run_.xAdvances[i];
+    }
+    return lround(width * run_.scale);
+  }
+
+  // Returns x, y, xAdvance and yAdvance of the next glyph.
+  void Next(size_t i, long* values) {
+    values[0] = lround((x_ + run_.xOffsets[i]) * run_.scale);
+    values[1] = lround((y_ + run_.yOffsets[i]) * run_.scale);
+    values[2] = lround(run_.xAdvances[i] * run_.scale);
+    values[3] = lround(run_.yAdvances[i] * run_.scale);
+    x_ += run_.xAdvances[i];
+    y_ += run_.yAdvances[i];
+  }
+
+ private:
+  const GlyphRun& run_;
+  int64_t x_, y_;
+};
+
+}  // namespace
+
+void AppendGlyphRunJSON(const std::string& id, const GlyphRun& run,
+                        std::string* out) {
+  GlyphPositioner positioner(run);
+  out->append("{\"id\":");
+  AppendJSONString(id, out);
+  out->append(",\"width\":");
+  AppendDecimal(positioner.GetWidth(), out);
+  out->append(",\"glyphs\":[");
+  for (size_t i = 0; i < run.GetSize(); ++i) {
+    long values[4];
+    positioner.Next(i, values);
+    out->append(i == 0 ? "[" : ",[");
+    AppendDecimal(static_cast<long>(run.glyphIDs[i]), out);
+    for (int k = 0; k < 4; ++k) {
+      out->push_back(',');
+      AppendDecimal(values[k], out);
+    }
+    out->push_back(']');
+  }
+  out->push_back(']');
+
+  if (!run.outlines.empty()) {
+    out->append(",\"outlines\":{");
+    for (size_t i = 0; i < run.outlines.size(); ++i) {
+      out->append(i == 0 ? "\"" : ",\"");
+      AppendDecimal(static_cast<long>(run.outlineGlyphIDs[i]), out);
+      out->append("\":");
+      AppendJSONString(run.outlines[i], out);
+    }
+    out->push_back('}');
+  }
+  out->push_back('}');
+}
+
+static void AppendUInt32(uint32_t value, std::string* out) {
+  out->push_back(static_cast<char>(value & 0xff));
+  out->push_back(static_cast<char>((value >> 8) & 0xff));
+  out->push_back(static_cast<char>((value >> 16) & 0xff));
+  out->push_back(static_cast<char>((value >> 24) & 0xff));
+}
+
+static void AppendInt32(long value, std::string* out) {
+  AppendUInt32(static_cast<uint32_t>(static_cast<int32_t>(value)), out);
+}
+
+void AppendGlyphRunBinary(const std::string& id, const GlyphRun& run,
+                          std::string* out) {
+  GlyphPositioner positioner(run);
+  out->append("FTGR");
+  AppendUInt32(static_cast<uint32_t>(id.size()), out);
+  out->append(id);
+  AppendInt32(positioner.GetWidth(), out);
+  AppendUInt32(static_cast<uint32_t>(run.GetSize()), out);
+  for (size_t i = 0; i < run.GetSize(); ++i) {
+    long values[4];
+    positioner.Next(i, values);
+    AppendUInt32(run.glyphIDs[i], out);
+    for (int k = 0; k < 4; ++k) {
+      AppendInt32(values[k], out);
+    }
+  }
+
+  AppendUInt32(static_cast<uint32_t>(run.outlines.size()), out);
+  for (size_t i = 0; i < run.outlines.size(); ++i) {
+    AppendUInt32(run.outlineGlyphIDs[i], out);
+    AppendUInt32(static_cast<uint32_t>(run.outlines[i].size()), out);
+    out->append(run.outlines[i]);
+  }
+}
+
+}  // namespace fonttest
@@ -0,0 +1,59 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_GLYPH_RUN_FORMAT_H_
+#define FONTTEST_GLYPH_RUN_FORMAT_H_
+
+#include <string>
+
+#include "fonttest/glyph_run.h"
+
+namespace fonttest {
+
+// What gets written for every rendered testcase.
+enum OutputFormat {
+  kFormatSVG,           // --format=svg, the default
+  kFormatGlyphsJSON,    // --format=glyphs
+  kFormatGlyphsBinary   // --format=glyphs-binary
+};
+
+// Parses the value of --format; an empty string means SVG.
+bool ParseOutputFormat(const std::string& name, OutputFormat* format);
+
+// Appends a glyph run as a single-line JSON object:
+//
+//   {"id":"SHARAN-1/1","width":1085,
+//    "glyphs":[[12,0,0,532,0],[7,532,0,553,0]],
+//    "outlines":{"12":"M10,20 L...","7":"M..."}}
+//
+// Every glyph is [glyphID, x, y, xAdvance, yAdvance], in the same
+// rounded SVG units as the x and y attributes of the <use> elements
+// that RenderSVG() would produce. "outlines" is only present if the
+// run contains outlines.
+void AppendGlyphRunJSON(const std::string& id, const GlyphRun& run,
+                        std::string* out);
+
+// Appends a glyph run in a compact binary encoding. All integers are
+// 32 bits wide and little-endian:
+//
+//   "FTGR" magic, idLength, id bytes, width, numGlyphs,
+//   numGlyphs * (glyphID, x, y, xAdvance, yAdvance),
+//   numOutlines, numOutlines * (glyphID, pathLength, path bytes)
+void AppendGlyphRunBinary(const std::string& id, const GlyphRun& run,
+                          std::string* out);
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_GLYPH_RUN_FORMAT_H_
@@ -0,0 +1,320 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <fribidi.h>
+#include <hb.h>
+#include <hb-ft.h>
+
+#include "fonttest/harfbuzz_line.h"
+#include "fonttest/perf_counters.h"
+#include "fonttest/trace.h"
+
+namespace fonttest {
+
+namespace {
+
+// A run of text with the same bidi level and script.
+struct LineRun {
+  int start, length;
+  FriBidiLevel level;
+  hb_script_t script;
+};
+
+// Buffers of the lines of one thread, kept from line to line.
+struct LineScratch {
+  LineScratch() : buffer(hb_buffer_create()), glyphRunInUse(false) {}
+  ~LineScratch() { hb_buffer_destroy(buffer); }
+
+  hb_buffer_t* buffer;
+  std::vector<FriBidiChar> text;
+  std::vector<FriBidiCharType> types;
+  std::vector<FriBidiBracketType> bracketTypes;
+  std::vector<FriBidiLevel> levels;
+  std::vector<hb_script_t> scripts;
+  std::vector<std::pair<hb_script_t, int> > brackets;  // script, pair index
+  std::vector<LineRun> levelRuns;
+  GlyphRun glyphRun;
+  bool glyphRunInUse;
+};
+
+thread_local LineScratch lineScratch;
+
+// Paired punctuation, with opening characters at even indices.
+// Same as in Raqm.
+const hb_codepoint_t kPairedChars[] = {
+  0x0028, 0x0029, 0x003c, 0x003e, 0x005b, 0x005d, 0x007b, 0x007d,
+  0x00ab, 0x00bb, 0x2018, 0x2019, 0x201c, 0x201d, 0x2039, 0x203a,
+  0x3008, 0x3009, 0x300a, 0x300b, 0x300c, 0x300d, 0x300e, 0x300f,
+  0x3010, 0x3011, 0x3014, 0x3015, 0x3016, 0x3017, 0x3018, 0x3019,
+  0x301a, 0x301b,
+};
+
+}  // namespace
+
+static int GetPairIndex(hb_codepoint_t c) {
+  const size_t count = sizeof(kPairedChars) / sizeof(kPairedChars[0]);
+  size_t lower = 0, upper = count;
+  while (lower < upper) {
+    const size_t mid = (lower + upper) / 2;
+    if (kPairedChars[mid] == c) {
+      return static_cast<int>(mid);
+    } else if (kPairedChars[mid] < c) {
+      lower = mid + 1;
+    } else {
+      upper = mid;
+    }
+  }
+  return -1;
+}
+
+// Resolves Common and Inherited characters to the script of their
+// context, like Raqm: paired punctuation takes the script of its opening
+// character, other characters that of the preceding text, and any
+// leading ones that of the following text. Also like Raqm, non-spacing
+// marks count as Inherited whatever their script, so that a Hebrew
+// point on a Latin letter does not start a Hebrew run.
+static void ResolveScripts(const FriBidiChar* text, int length,
+                           std::vector<hb_script_t>* scripts) {
+  TraceSpan span("itemize");
+  hb_unicode_funcs_t* unicodeFuncs = hb_unicode_funcs_get_default();
+  scripts->resize(length);
+  hb_script_t* script = scripts->data();
+  for (int i = 0; i < length; ++i) {
+    if (hb_unicode_general_category(unicodeFuncs, text[i]) ==
+        HB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK) {
+      script[i] = HB_SCRIPT_INHERITED;
+    } else {
+      script[i] = hb_unicode_script(unicodeFuncs, text[i]);
+    }
+  }
+
+  std::vector<std::pair<hb_script_t, int> >& brackets = lineScratch.brackets;
+  brackets.clear();
+  int lastScriptIndex = -1, lastSetIndex = -1;
+  hb_script_t lastScript = HB_SCRIPT_INVALID;
+  for (int i = 0; i < length; ++i) {
+    if (script[i] == HB_SCRIPT_COMMON && lastScriptIndex != -1) {
+      const int pairIndex = GetPairIndex(text[i]);
+      if (pairIndex >= 0 && (pairIndex & 1) == 0) {
+        brackets.push_back(std::make_pair(lastScript, pairIndex));
+      } else if (pairIndex >= 0) {
+        while (!brackets.empty() &&
+               brackets.back().second != (pairIndex & ~1)) {
+          brackets.pop_back();
+        }
+        // Like Raqm, leave the opening character on the stack, so that
+        // a stray closing one after it gets the same script.
+        if (!brackets.empty()) {
+          lastScript = brackets.back().first;
+        }
+      }
+      script[i] = lastScript;
+      lastSetIndex = i;
+    } else if (script[i] == HB_SCRIPT_INHERITED && lastScriptIndex != -1) {
+      script[i] = lastScript;
+      lastSetIndex = i;
+    } else {
+      for (int j = lastSetIndex + 1; j < i; ++j) {
+        script[j] = script[i];
+      }
+      lastScript = script[i];
+      lastScriptIndex = lastSetIndex = i;
+    }
+  }
+
+  for (int i = length - 2; i >= 0; --i) {
+    if (script[i] == HB_SCRIPT_INHERITED || script[i] == HB_SCRIPT_COMMON) {
+      script[i] = script[i + 1];
+    }
+  }
+}
+
+// Splits the text into runs of equal bidi level, in visual order.
+static bool ResolveLevelRuns(const FriBidiChar* text, int length,
+                             std::vector<LineRun>* runs) {
+  TraceSpan span("bidi");
+  LineScratch& scratch = lineScratch;
+  scratch.types.resize(length);
+  scratch.bracketTypes.resize(length);
+  scratch.levels.resize(length);
+  FriBidiCharType* types = scratch.types.data();
+  FriBidiLevel* levels = scratch.levels.data();
+  fribidi_get_bidi_types(text, length, types);
+  fribidi_get_bracket_types(text, length, types, scratch.bracketTypes.data());
+  FriBidiParType baseDirection = FRIBIDI_PAR_ON;
+  if (!fribidi_get_par_embedding_levels_ex(types, scratch.bracketTypes.data(),
+                                           length, &baseDirection, levels)) {
+    return false;
+  }
+
+  // Rule L1: trailing whitespace goes back to the paragraph level.
+  for (int i = length - 1;
+       i >= 0 && FRIBIDI_IS_EXPLICIT_OR_BN_OR_WS(types[i]); --i) {
+    levels[i] = FRIBIDI_DIR_TO_LEVEL(baseDirection);
+  }
+
+  runs->clear();
+  FriBidiLevel maxLevel = 0;
+  for (int i = 0; i < length; ++i) {
+    if (runs->empty() || levels[i] != runs->back().level) {
+      LineRun run = {i, 0, levels[i], HB_SCRIPT_INVALID};
+      runs->push_back(run);
+      maxLevel = std::max(maxLevel, levels[i]);
+    }
+    ++runs->back().length;
+  }
+
+  // Rule L2: from the highest level down, reverse every sequence of
+  // runs at that level or above.
+  for (FriBidiLevel level = maxLevel; level > 0; --level) {
+    for (int i = static_cast<int>(runs->size()) - 1; i >= 0; --i) {
+      if ((*runs)[i].level >= level) {
+        const int end = i;
+        while (i > 0 && (*runs)[i - 1].level >= level) {
+          --i;
+        }
+        std::reverse(runs->begin() + i, runs->begin() + end + 1);
+      }
+    }
+  }
+  return true;
+}
+
+HarfBuzzInstance::HarfBuzzInstance(FT_Face face)
+  : font_(hb_ft_font_create_referenced(face)) {
+}
+
+HarfBuzzInstance::~HarfBuzzInstance() {
+  hb_font_destroy(font_);
+}
+
+HarfBuzzLine::HarfBuzzLine(const std::string& text,
+                           const std::string& textLanguage,
+                           HarfBuzzInstance* instance)
+  : glyphRun_(&ownGlyphRun_), ok_(false) {
+  TraceSpan span("HarfBuzzLine");
+  PerfScope perf(kPerfStageShaping);
+  LineScratch& scratch = lineScratch;
+  if (!scratch.glyphRunInUse) {
+    scratch.glyphRunInUse = true;
+    glyphRun_ = &scratch.glyphRun;
+  }
+  glyphRun_->Clear();
+  glyphRun_->scale = 1.0 / 64;  // hb-ft positions in 26.6 pixels
+
+  scratch.text.resize(text.length() + 1);
+  const int length = fribidi_charset_to_unicode(
+      FRIBIDI_CHAR_SET_UTF8, text.c_str(),
+      static_cast<FriBidiStrIndex>(text.length()), scratch.text.data());
+  if (length <= 0) {
+    ok_ = true;
+    return;
+  }
+  const FriBidiChar* codepoints = scratch.text.data();
+  if (!ResolveLevelRuns(codepoints, length, &scratch.levelRuns)) {
+    std::cerr << "fribidi_get_par_embedding_levels_ex() has failed"
+              << std::endl;
+    return;
+  }
+  ResolveScripts(codepoints, length, &scratch.scripts);
+
+  // Like Raqm, an empty language is HB_LANGUAGE_INVALID, not the default.
+  const hb_language_t language =
+      hb_language_from_string(textLanguage.c_str(), -1);
+  hb_buffer_t* buffer = scratch.buffer;
+  hb_font_t* font = instance->GetFont();
+  for (const LineRun& levelRun : scratch.levelRuns) {
+    // Split by script, visiting right-to-left runs from their end so
+    // that the pieces come out in visual order.
+    const bool rtl = FRIBIDI_LEVEL_IS_RTL(levelRun.level);
+    const int end = levelRun.start + levelRun.length;
+    int pos = rtl ? end - 1 : levelRun.start;
+    while (rtl ? pos >= levelRun.start : pos < end) {
+      const hb_script_t script = scratch.scripts[pos];
+      int start = pos, limit = pos + 1;
+      if (rtl) {
+        while (start > levelRun.start && scratch.scripts[start - 1] == script) {
+          --start;
+        }
+        pos = start - 1;
+      } else {
+        while (limit < end && scratch.scripts[limit] == script) {
+          ++limit;
+        }
+        pos = limit;
+      }
+
+      TraceSpan shapeSpan("shape");
+      hb_buffer_clear_contents(buffer);
+      hb_buffer_add_utf32(buffer, codepoints, length, start, limit - start);
+      hb_buffer_set_direction(buffer,
+                              rtl ? HB_DIRECTION_RTL : HB_DIRECTION_LTR);
+      hb_buffer_set_script(buffer, script);
+      hb_buffer_set_language(buffer, language);
+      // Every run is flagged as the beginning and end of text, as Raqm
+      // does, so that a leading mark gets a dotted circle.
+      hb_buffer_set_flags(buffer, static_cast<hb_buffer_flags_t>(
+          HB_BUFFER_FLAG_BOT | HB_BUFFER_FLAG_EOT |
+          HB_BUFFER_FLAG_REMOVE_DEFAULT_IGNORABLES));
+      // Not hb_shape_plan_execute() with a plan of our own: only
+      // hb_shape_full() bounds the buffer's length and operation count,
+      // without which a malicious GSUB (as in GSUB-3) never finishes.
+      // The plan comes from the cache of the font's hb_face_t.
+      if (!hb_shape_full(font, buffer, NULL, 0, NULL)) {
+        std::cerr << "hb_shape_full() has failed" << std::endl;
+        return;
+      }
+
+      unsigned int numGlyphs = 0;
+      const hb_glyph_info_t* infos =
+          hb_buffer_get_glyph_infos(buffer, &numGlyphs);
+      const hb_glyph_position_t* positions =
+          hb_buffer_get_glyph_positions(buffer, &numGlyphs);
+      for (unsigned int i = 0; i < numGlyphs; ++i) {
+        glyphRun_->Append(infos[i].codepoint,
+                          positions[i].x_offset, positions[i].y_offset,
+                          positions[i].x_advance, positions[i].y_advance);
+      }
+    }
+  }
+  ok_ = true;
+}
+
+HarfBuzzLine::~HarfBuzzLine() {
+  if (glyphRun_ != &ownGlyphRun_) {
+    lineScratch.glyphRunInUse = false;
+  }
+}
+
+bool HarfBuzzLine::GetGlyphRun(GlyphRun* run) const {
+  if (!ok_) {
+    run->Clear();
+    return false;
+  }
+  *run = *glyphRun_;
+  return true;
+}
+
+}  // namespace fonttest
@@ -0,0 +1,77 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_HARFBUZZ_LINE_H_
+#define FONTTEST_HARFBUZZ_LINE_H_
+
+#include <string>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <hb.h>
+
+#include "fonttest/glyph_run.h"
+
+namespace fonttest {
+
+// The HarfBuzz font for one instance of a FreeStackFont, kept from line
+// to line. Its hb_face_t caches the shape plans compiled for it, so
+// they are reused too. Raqm sets up a new HarfBuzz font (and with it, a
+// new face with an empty plan cache) for every line.
+class HarfBuzzInstance {
+ public:
+  // |face| must be set up for the instance, both now and whenever the
+  // instance is used for shaping.
+  explicit HarfBuzzInstance(FT_Face face);
+  ~HarfBuzzInstance();
+
+  hb_font_t* GetFont() const { return font_; }
+
+ private:
+  HarfBuzzInstance(const HarfBuzzInstance&);
+  void operator=(const HarfBuzzInstance&);
+
+  hb_font_t* font_;
+};
+
+// Lays out a line of text like FreeStackLine, but without Raqm: bidi
+// levels come from FriBidi, scripts are resolved the way Raqm does it,
+// and every run is shaped with the font of |instance|.
+class HarfBuzzLine {
+ public:
+  HarfBuzzLine(const std::string& text, const std::string& textLanguage,
+               HarfBuzzInstance* instance);
+  ~HarfBuzzLine();
+
+  // Replaces the contents of |run| by the shaped glyphs of this line.
+  // Returns false, with |run| empty, if the line could not be shaped.
+  bool GetGlyphRun(GlyphRun* run) const;
+
+ private:
+  HarfBuzzLine(const HarfBuzzLine&);
+  void operator=(const HarfBuzzLine&);
+
+  // Points to a glyph run that the thread's lines share, so that shaping
+  // reuses its capacity; or to ownGlyphRun_, if another line on the same
+  // thread is still holding the shared one.
+  GlyphRun* glyphRun_;
+  GlyphRun ownGlyphRun_;
+  bool ok_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_HARFBUZZ_LINE_H_
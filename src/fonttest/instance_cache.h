@@ -0,0 +1,97 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_INSTANCE_CACHE_H_
+#define FONTTEST_INSTANCE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace fonttest {
+
+// Counts the lookups of all instance caches of one engine.
+struct InstanceCacheStats {
+  InstanceCacheStats() : hits(0), misses(0), evictions(0) {}
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+};
+
+// Keeps the shaping objects of the most recently used instances of a
+// font, such as its HarfBuzz fonts by size and variation. Each object
+// holds parsed tables and plans, so a font that is rendered at many
+// instances would otherwise grow without bound. When the capacity is
+// exceeded, the least recently used object is deleted. Not thread-safe;
+// every font belongs to one engine.
+template <typename Key, typename Value>
+class InstanceCache {
+ public:
+  // |stats| may be NULL; otherwise, it must outlive the cache.
+  InstanceCache(size_t capacity, InstanceCacheStats* stats)
+    : capacity_(capacity), stats_(stats) {}
+
+  // Returns the object for |key|, or NULL. The returned pointer stays
+  // valid until the next call to Insert().
+  Value* Find(const Key& key) {
+    typename Index::iterator iter = index_.find(key);
+    if (iter == index_.end()) {
+      if (stats_) {
+        ++stats_->misses;
+      }
+      return NULL;
+    }
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    if (stats_) {
+      ++stats_->hits;
+    }
+    return iter->second->second.get();
+  }
+
+  // Adds the object for |key|, which must not be in the cache yet.
+  Value* Insert(const Key& key, std::unique_ptr<Value> value) {
+    entries_.push_front(std::make_pair(key, std::move(value)));
+    index_[key] = entries_.begin();
+    while (entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+      if (stats_) {
+        ++stats_->evictions;
+      }
+    }
+    return entries_.front().second.get();
+  }
+
+  void Clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+ private:
+  typedef std::list<std::pair<Key, std::unique_ptr<Value> > > EntryList;
+  typedef std::map<Key, typename EntryList::iterator> Index;
+
+  size_t capacity_;
+  InstanceCacheStats* stats_;
+  EntryList entries_;  // most recently used first
+  Index index_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_INSTANCE_CACHE_H_
@@ -0,0 +1,271 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+#include "fonttest/json.h"
+
+namespace fonttest {
+
+namespace {
+
+class JSONParser {
+ public:
+  JSONParser(const std::string& text) : text_(text), pos_(0) {}
+
+  bool ParseRecord(JSONRecord* record, std::string* error) {
+    record->clear();
+    SkipWhitespace();
+    if (!Consume('{')) {
+      return Fail("expected '{'", error);
+    }
+    SkipWhitespace();
+    if (Consume('}')) {
+      return AtEnd() || Fail("trailing characters", error);
+    }
+    while (true) {
+      std::string key, value;
+      bool isNull = false;
+      SkipWhitespace();
+      if (!ParseString(&key)) {
+        return Fail("expected string key", error);
+      }
+      SkipWhitespace();
+      if (!Consume(':')) {
+        return Fail("expected ':'", error);
+      }
+      SkipWhitespace();
+      if (!ParseValue(&value, &isNull)) {
+        return Fail("malformed value for key \"" + key + "\"", error);
+      }
+      if (!isNull) {
+        (*record)[key] = value;
+      }
+      SkipWhitespace();
+      if (Consume(',')) {
+        continue;
+      }
+      if (Consume('}')) {
+        break;
+      }
+      return Fail("expected ',' or '}'", error);
+    }
+    return AtEnd() || Fail("trailing characters", error);
+  }
+
+ private:
+  bool Fail(const std::string& message, std::string* error) {
+    if (error) {
+      *error = message + " at offset " + std::to_string(pos_);
+    }
+    return false;
+  }
+
+  bool AtEnd() {
+    SkipWhitespace();
+    return pos_ == text_.size();
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' ||
+            text_[pos_] == '\n' || text_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  bool Consume(char c) {
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  bool ConsumeLiteral(const char* literal) {
+    const std::string::size_type len = std::char_traits<char>::length(literal);
+    if (text_.compare(pos_, len, literal) == 0) {
+      pos_ += len;
+      return true;
+    }
+    return false;
+  }
+
+  bool ParseValue(std::string* value, bool* isNull) {
+    if (pos_ >= text_.size()) {
+      return false;
+    }
+    const char c = text_[pos_];
+    if (c == '"') {
+      return ParseString(value);
+    }
+    if (ConsumeLiteral("true")) {
+      value->assign("true");
+      return true;
+    }
+    if (ConsumeLiteral("false")) {
+      value->assign("false");
+      return true;
+    }
+    if (ConsumeLiteral("null")) {
+      *isNull = true;
+      return true;
+    }
+    const std::string::size_type start = pos_;
+    while (pos_ < text_.size() &&
+           (isdigit(static_cast<unsigned char>(text_[pos_])) ||
+            text_[pos_] == '-' || text_[pos_] == '+' ||
+            text_[pos_] == '.' || text_[pos_] == 'e' || text_[pos_] == 'E')) {
+      ++pos_;
+    }
+    if (pos_ == start) {
+      return false;
+    }
+    value->assign(text_, start, pos_ - start);
+    return true;
+  }
+
+  bool ParseHex4(uint32_t* result) {
+    if (pos_ + 4 > text_.size()) {
+      return false;
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      const char c = text_[pos_++];
+      value <<= 4;
+      if (c >= '0' && c <= '9') {
+        value |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        value |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        value |= c - 'A' + 10;
+      } else {
+        return false;
+      }
+    }
+    *result = value;
+    return true;
+  }
+
+  static void AppendUTF8(uint32_t c, std::string* out) {
+    if (c < 0x80) {
+      out->push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+      out->push_back(static_cast<char>(0xC0 | (c >> 6)));
+      out->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+      out->push_back(static_cast<char>(0xE0 | (c >> 12)));
+      out->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+      out->push_back(static_cast<char>(0xF0 | (c >> 18)));
+      out->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+  }
+
+  bool ParseString(std::string* result) {
+    result->clear();
+    if (!Consume('"')) {
+      return false;
+    }
+    while (pos_ < text_.size()) {
+      const char c = text_[pos_++];
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\') {
+        result->push_back(c);
+        continue;
+      }
+      if (pos_ >= text_.size()) {
+        return false;
+      }
+      const char escape = text_[pos_++];
+      switch (escape) {
+        case '"': result->push_back('"'); break;
+        case '\\': result->push_back('\\'); break;
+        case '/': result->push_back('/'); break;
+        case 'b': result->push_back('\b'); break;
+        case 'f': result->push_back('\f'); break;
+        case 'n': result->push_back('\n'); break;
+        case 'r': result->push_back('\r'); break;
+        case 't': result->push_back('\t'); break;
+        case 'u': {
+          uint32_t codepoint;
+          if (!ParseHex4(&codepoint)) {
+            return false;
+          }
+          if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+            uint32_t low;
+            if (!ConsumeLiteral("\\u") || !ParseHex4(&low) ||
+                low < 0xDC00 || low > 0xDFFF) {
+              return false;
+            }
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) +
+                (low - 0xDC00);
+          }
+          AppendUTF8(codepoint, result);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+    return false;
+  }
+
+  const std::string& text_;
+  std::string::size_type pos_;
+};
+
+}  // namespace
+
+bool ParseJSONRecord(const std::string& text, JSONRecord* record,
+                     std::string* error) {
+  JSONParser parser(text);
+  return parser.ParseRecord(record, error);
+}
+
+void AppendJSONString(const std::string& str, std::string* out) {
+  static const char hexDigits[] = "0123456789abcdef";
+  out->push_back('"');
+  for (std::string::const_iterator iter = str.begin();
+       iter != str.end(); ++iter) {
+    const unsigned char c = static_cast<unsigned char>(*iter);
+    switch (c) {
+      case '"': out->append("\\\""); break;
+      case '\\': out->append("\\\\"); break;
+      case '\n': out->append("\\n"); break;
+      case '\r': out->append("\\r"); break;
+      case '\t': out->append("\\t"); break;
+      default:
+        if (c < 0x20) {
+          out->append("\\u00");
+          out->push_back(hexDigits[c >> 4]);
+          out->push_back(hexDigits[c & 0xF]);
+        } else {
+          out->push_back(static_cast<char>(c));
+        }
+        break;
+    }
+  }
+  out->push_back('"');
+}
+
+}  // namespace fonttest
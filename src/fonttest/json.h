@@ -0,0 +1,39 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_JSON_H_
+#define FONTTEST_JSON_H_
+
+#include <map>
+#include <string>
+
+namespace fonttest {
+
+// A flat JSON object, such as {"id": "AVAR-1/789", "faceIndex": 0}.
+// Numbers and booleans are kept in their textual form; null values
+// are dropped.
+typedef std::map<std::string, std::string> JSONRecord;
+
+// Parses one line of a JSON Lines stream. Nested objects and arrays
+// are not supported, since the batch protocol does not need them.
+bool ParseJSONRecord(const std::string& text, JSONRecord* record,
+                     std::string* error);
+
+// Appends a quoted and escaped JSON string literal to |out|.
+void AppendJSONString(const std::string& str, std::string* out);
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_JSON_H_
@@ -24,6 +24,5 @@ int main(int argc, const char** argv) {
   }
 
   fonttest::TestHarness harness(args);
-  harness.Run();
-  return 0;
+  return harness.Run();
 }
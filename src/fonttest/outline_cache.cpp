@@ -0,0 +1,107 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+
+#include "fonttest/outline_cache.h"
+
+namespace fonttest {
+
+OutlineCache::OutlineCache()
+  : maxBytes_(kDefaultMaxBytes) {
+}
+
+OutlineCache::~OutlineCache() {
+}
+
+OutlineCache::Instance* OutlineCache::GetInstance(
+    const FontInstanceKey& key) {
+  std::unique_ptr<Instance>& instance = instances_[key];
+  if (!instance) {
+    instance.reset(new Instance);
+    instance->key_ = key;
+  }
+  return instance.get();
+}
+
+const std::string* OutlineCache::Find(Instance* instance, uint32_t glyphID) {
+  auto found = instance->glyphs_.find(glyphID);
+  if (found == instance->glyphs_.end()) {
+    ++stats_.misses;
+    return NULL;
+  }
+
+  ++stats_.hits;
+  entries_.splice(entries_.begin(), entries_, found->second);
+  return &found->second->path;
+}
+
+void OutlineCache::Insert(Instance* instance, uint32_t glyphID,
+                          const std::string& path) {
+  auto found = instance->glyphs_.find(glyphID);
+  if (found != instance->glyphs_.end()) {
+    stats_.bytes -= EntryBytes(*found->second);
+    found->second->path = path;
+    stats_.bytes += EntryBytes(*found->second);
+    entries_.splice(entries_.begin(), entries_, found->second);
+  } else {
+    Entry entry;
+    entry.instance = instance;
+    entry.glyphID = glyphID;
+    entry.path = path;
+    entries_.push_front(entry);
+    instance->glyphs_[glyphID] = entries_.begin();
+    stats_.bytes += EntryBytes(entries_.front());
+    ++stats_.entries;
+  }
+  EvictToLimit(instance);
+}
+
+void OutlineCache::SetMaxBytes(size_t maxBytes) {
+  maxBytes_ = maxBytes;
+  EvictToLimit(NULL);
+}
+
+void OutlineCache::Clear() {
+  entries_.clear();
+  instances_.clear();
+  stats_.bytes = 0;
+  stats_.entries = 0;
+}
+
+size_t OutlineCache::EntryBytes(const Entry& entry) {
+  return sizeof(Entry) + entry.path.capacity();
+}
+
+// Evicts the least recently used outlines until we are within budget.
+// Empty instance tables are dropped too, except for |keep| which the
+// caller is still holding on to.
+void OutlineCache::EvictToLimit(const Instance* keep) {
+  while (stats_.bytes > maxBytes_ && !entries_.empty()) {
+    Entry& victim = entries_.back();
+    Instance* instance = victim.instance;
+    instance->glyphs_.erase(victim.glyphID);
+    stats_.bytes -= EntryBytes(victim);
+    --stats_.entries;
+    ++stats_.evictions;
+    entries_.pop_back();
+    if (instance->glyphs_.empty() && instance != keep) {
+      instances_.erase(instance->key_);
+    }
+  }
+}
+
+}  // namespace fonttest
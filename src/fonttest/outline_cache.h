@@ -0,0 +1,92 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_OUTLINE_CACHE_H_
+#define FONTTEST_OUTLINE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "fonttest/font_instance_key.h"
+
+namespace fonttest {
+
+// Caches converted glyph outlines (in SVG path format) across renders.
+// Memory use is bounded by the total size of the cached path strings;
+// when the limit is exceeded, the least recently used outlines are
+// evicted. Not thread-safe; every engine owns its own cache.
+class OutlineCache {
+ public:
+  class Instance;
+
+  struct Stats {
+    Stats() : hits(0), misses(0), evictions(0), bytes(0), entries(0) {}
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t bytes;
+    size_t entries;
+  };
+
+  static const size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+
+  OutlineCache();
+  ~OutlineCache();
+
+  // Looks up the per-instance table, creating it if needed. Callers
+  // should do this once per render, not once per glyph.
+  Instance* GetInstance(const FontInstanceKey& key);
+
+  // Returns the cached path of a glyph, or NULL. The returned pointer
+  // stays valid until the next call to Insert().
+  const std::string* Find(Instance* instance, uint32_t glyphID);
+  void Insert(Instance* instance, uint32_t glyphID, const std::string& path);
+
+  void SetMaxBytes(size_t maxBytes);
+  const Stats& GetStats() const { return stats_; }
+  void Clear();
+
+ private:
+  struct Entry {
+    Instance* instance;
+    uint32_t glyphID;
+    std::string path;
+  };
+  typedef std::list<Entry> EntryList;
+
+  void EvictToLimit(const Instance* keep);
+  static size_t EntryBytes(const Entry& entry);
+
+  size_t maxBytes_;
+  EntryList entries_;  // most recently used first
+  std::map<FontInstanceKey, std::unique_ptr<Instance> > instances_;
+  Stats stats_;
+};
+
+class OutlineCache::Instance {
+ private:
+  friend class OutlineCache;
+  FontInstanceKey key_;
+  std::unordered_map<uint32_t, OutlineCache::EntryList::iterator> glyphs_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_OUTLINE_CACHE_H_
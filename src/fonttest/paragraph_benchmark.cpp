@@ -0,0 +1,161 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/resource.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fonttest/benchmark.h"
+#include "fonttest/font.h"
+#include "fonttest/font_engine.h"
+#include "fonttest/glyph_run.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+namespace {
+
+// Every non-empty line of a corpus file is a paragraph, which gets
+// rendered as a single line of text. Test fonts have a limited
+// character set: arabic.txt only uses the Urdu letters covered by
+// TestShapeAran.ttf, and balinese.txt is made of random syllables.
+struct Corpus {
+  const char* name;
+  const char* font;
+  const char* textLanguage;
+  const char* variation;
+};
+
+const Corpus kCorpora[] = {
+  {"arabic", "TestShapeAran.ttf", "ur", ""},
+  {"balinese", "NotoSansBalinese-Regular.ttf", "ban", ""},
+  {"kannada", "NotoSansKannada-Regular.ttf", "kn", ""},
+  {"latin", "Selawik-variable.ttf", "en", "wght:650"},
+};
+
+const char* const kEngines[] = {"FreeStack", "FreeStackHB", "TehreerStack"};
+
+std::vector<std::string> ReadParagraphs(const std::string& path) {
+  std::ifstream input(path.c_str());
+  if (!input) {
+    std::cerr << "failed to open corpus: " << path << std::endl;
+    exit(1);
+  }
+  std::vector<std::string> paragraphs;
+  std::string line;
+  while (std::getline(input, line)) {
+    if (!line.empty()) {
+      paragraphs.push_back(line);
+    }
+  }
+  return paragraphs;
+}
+
+// Returns the peak resident set size of this process, in kilobytes.
+long GetPeakRSSKilobytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;  // bytes on Mac OS X
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+// Returns false if all benchmarks for |corpus| were filtered out.
+bool RunCorpusBenchmarks(BenchmarkRunner* runner, FontEngine* engine,
+                         const Corpus& corpus) {
+  const std::string prefix =
+      "paragraph/" + engine->GetName() + "/" + corpus.name;
+  if (!runner->IsEnabled(prefix + "/shape") &&
+      !runner->IsEnabled(prefix + "/render")) {
+    return false;
+  }
+
+  const std::vector<std::string> paragraphs =
+      ReadParagraphs(runner->GetCorpusDir() + "/" + corpus.name + ".txt");
+  const std::string fontPath = runner->GetFontDir() + "/" + corpus.font;
+  std::unique_ptr<Font> font(engine->LoadFont(fontPath, 0));
+  if (!font) {
+    std::cerr << "failed to load font: " << fontPath << std::endl;
+    exit(1);
+  }
+  FontVariation variation;
+  if (!ParseVariationSpec(corpus.variation, &variation)) {
+    std::cerr << "malformed variation: " << corpus.variation << std::endl;
+    exit(1);
+  }
+
+  GlyphRun run;
+  size_t numGlyphs = 0;
+  for (const std::string& paragraph : paragraphs) {
+    if (!engine->RenderGlyphs(paragraph, corpus.textLanguage, font.get(),
+                              Renderer::kFontSize, variation, false, &run)) {
+      return false;
+    }
+    numGlyphs += run.GetSize();
+  }
+
+  std::vector<BenchmarkRunner::Rate> rates;
+  rates.push_back(BenchmarkRunner::Rate("glyphs", numGlyphs));
+  rates.push_back(BenchmarkRunner::Rate("lines", paragraphs.size()));
+  runner->Run(prefix + "/shape", rates, [&]() {
+    for (const std::string& paragraph : paragraphs) {
+      engine->RenderGlyphs(paragraph, corpus.textLanguage, font.get(),
+                           Renderer::kFontSize, variation, false, &run);
+      runner->Consume(run.GetSize());
+    }
+  });
+
+  std::string svg;
+  runner->Run(prefix + "/render", rates, [&]() {
+    for (const std::string& paragraph : paragraphs) {
+      engine->RenderSVG(paragraph, corpus.textLanguage, font.get(),
+                        Renderer::kFontSize, variation, corpus.name, &svg);
+      runner->Consume(svg.size());
+    }
+  });
+  return true;
+}
+
+}  // namespace
+
+void RunParagraphBenchmarks(BenchmarkRunner* runner) {
+  for (const char* engineName : kEngines) {
+    std::unique_ptr<FontEngine> engine(FontEngine::Create(engineName));
+    if (!engine) {
+      continue;
+    }
+    bool ran = false;
+    for (const Corpus& corpus : kCorpora) {
+      ran |= RunCorpusBenchmarks(runner, engine.get(), corpus);
+    }
+
+    // The peak is process-wide, so it includes earlier benchmarks.
+    if (ran) {
+      std::cout << "paragraph/" << engineName << "/peak_rss: "
+                << GetPeakRSSKilobytes() << " KB" << std::endl;
+    }
+  }
+}
+
+}  // namespace fonttest
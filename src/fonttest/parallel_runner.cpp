@@ -0,0 +1,278 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "fonttest/disk_cache.h"
+#include "fonttest/font_cache.h"
+#include "fonttest/font_engine.h"
+#include "fonttest/freetype_memory.h"
+#include "fonttest/instance_cache.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/parallel_runner.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+ParallelRunner::ParallelRunner(const std::string& engineName,
+                               int numThreads)
+  : maxQueueSize_(0), maxPending_(0), nextSequence_(0), inputDone_(false),
+    nextToDeliver_(0) {
+  if (numThreads <= 0) {
+    numThreads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  if (numThreads <= 0) {
+    numThreads = 1;
+  }
+
+  for (int i = 0; i < numThreads; ++i) {
+    std::unique_ptr<Worker> worker(new Worker);
+    worker->engine.reset(FontEngine::Create(engineName));
+    if (!worker->engine) {
+      workers_.clear();
+      return;
+    }
+    worker->renderer.reset(new Renderer(worker->engine.get()));
+    workers_.push_back(std::move(worker));
+  }
+  maxQueueSize_ = 4 * workers_.size();
+  maxPending_ = 4 * maxQueueSize_;
+}
+
+ParallelRunner::~ParallelRunner() {
+  Finish();
+}
+
+void ParallelRunner::SetFontCacheCapacity(size_t capacity) {
+  for (auto& worker : workers_) {
+    worker->engine->GetFontCache()->SetCapacity(capacity);
+  }
+}
+
+void ParallelRunner::SetOutlineCacheMaxBytes(size_t maxBytes) {
+  for (auto& worker : workers_) {
+    OutlineCache* outlineCache = worker->engine->GetOutlineCache();
+    if (outlineCache) {
+      outlineCache->SetMaxBytes(maxBytes);
+    }
+  }
+}
+
+void ParallelRunner::SetOutputFormat(OutputFormat format, bool withOutlines) {
+  for (auto& worker : workers_) {
+    worker->renderer->SetOutputFormat(format, withOutlines);
+  }
+}
+
+void ParallelRunner::SetMemoryStatsOutput(std::ostream* output) {
+  for (auto& worker : workers_) {
+    worker->renderer->SetMemoryStatsOutput(output);
+  }
+}
+
+void ParallelRunner::SetCanonicalSVG(bool canonical) {
+  for (auto& worker : workers_) {
+    worker->renderer->SetCanonicalSVG(canonical);
+  }
+}
+
+void ParallelRunner::SetDiskCacheDirectory(const std::string& directory) {
+  for (auto& worker : workers_) {
+    worker->diskCache.reset(new DiskCache(directory));
+    worker->renderer->SetDiskCache(worker->diskCache.get());
+  }
+}
+
+void ParallelRunner::Start(const ResultCallback& callback) {
+  callback_ = callback;
+  for (auto& worker : workers_) {
+    worker->thread = std::thread(&ParallelRunner::WorkerLoop, this,
+                                 worker.get());
+  }
+}
+
+void ParallelRunner::Add(const RenderJob& job) {
+  Task task;
+  task.job = job;
+  task.failed = false;
+  Enqueue(task);
+}
+
+void ParallelRunner::AddFailed(const RenderJob& job,
+                               const std::string& error) {
+  Task task;
+  task.job = job;
+  task.failed = true;
+  task.error = error;
+  Enqueue(task);
+}
+
+void ParallelRunner::Enqueue(const Task& task) {
+  std::unique_lock<std::mutex> lock(queueMutex_);
+  queueNotFull_.wait(lock, [this] {
+    return queue_.size() < maxQueueSize_ &&
+        nextSequence_ - nextToDeliver_ < maxPending_;
+  });
+  queue_.push_back(task);
+  queue_.back().sequence = nextSequence_++;
+  queueNotEmpty_.notify_one();
+}
+
+void ParallelRunner::Finish() {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    inputDone_ = true;
+  }
+  queueNotEmpty_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+void ParallelRunner::WorkerLoop(Worker* worker) {
+  // Reused for every job, so that its output buffer keeps its capacity.
+  RenderResult result;
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex_);
+      queueNotEmpty_.wait(lock,
+                          [this] { return inputDone_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      task = queue_.front();
+      queue_.pop_front();
+    }
+    queueNotFull_.notify_one();
+
+    if (task.failed) {
+      result.ok = false;
+      result.error = task.error;
+      result.output.clear();
+    } else {
+      worker->renderer->Render(task.job, &result);
+    }
+    Deliver(task.sequence, task.job, result);
+  }
+}
+
+void ParallelRunner::Deliver(size_t sequence, const RenderJob& job,
+                             const RenderResult& result) {
+  {
+    std::lock_guard<std::mutex> lock(deliveryMutex_);
+    if (sequence != nextToDeliver_) {
+      completed_[sequence] = std::make_pair(job, result);
+      return;
+    }
+
+    callback_(job, result);
+    ++nextToDeliver_;
+    auto iter = completed_.begin();
+    while (iter != completed_.end() && iter->first == nextToDeliver_) {
+      callback_(iter->second.first, iter->second.second);
+      ++nextToDeliver_;
+      iter = completed_.erase(iter);
+    }
+  }
+
+  // Enqueue() may be waiting for the delivery; taking the queue lock
+  // makes sure that it either sees the new count or gets the wakeup.
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+  }
+  queueNotFull_.notify_all();
+}
+
+FontCache::Stats ParallelRunner::GetFontCacheStats() const {
+  FontCache::Stats total;
+  for (const auto& worker : workers_) {
+    const FontCache::Stats& stats = worker->engine->GetFontCache()->GetStats();
+    total.hits += stats.hits;
+    total.misses += stats.misses;
+    total.evictions += stats.evictions;
+  }
+  return total;
+}
+
+OutlineCache::Stats ParallelRunner::GetOutlineCacheStats() const {
+  OutlineCache::Stats total;
+  for (const auto& worker : workers_) {
+    const OutlineCache* outlineCache = worker->engine->GetOutlineCache();
+    if (!outlineCache) {
+      continue;
+    }
+    const OutlineCache::Stats& stats = outlineCache->GetStats();
+    total.hits += stats.hits;
+    total.misses += stats.misses;
+    total.evictions += stats.evictions;
+    total.bytes += stats.bytes;
+    total.entries += stats.entries;
+  }
+  return total;
+}
+
+DiskCache::Stats ParallelRunner::GetDiskCacheStats() const {
+  DiskCache::Stats total;
+  for (const auto& worker : workers_) {
+    if (!worker->diskCache) {
+      continue;
+    }
+    const DiskCache::Stats& stats = worker->diskCache->GetStats();
+    total.hits += stats.hits;
+    total.misses += stats.misses;
+    total.stores += stats.stores;
+  }
+  return total;
+}
+
+InstanceCacheStats ParallelRunner::GetInstanceCacheStats() const {
+  InstanceCacheStats total;
+  for (const auto& worker : workers_) {
+    const InstanceCacheStats* stats = worker->engine->GetInstanceCacheStats();
+    if (!stats) {
+      continue;
+    }
+    total.hits += stats->hits;
+    total.misses += stats->misses;
+    total.evictions += stats->evictions;
+  }
+  return total;
+}
+
+FreeTypeMemory::Stats ParallelRunner::GetFreeTypeMemoryStats() const {
+  FreeTypeMemory::Stats total;
+  for (const auto& worker : workers_) {
+    const FreeTypeMemory* memory = worker->engine->GetFreeTypeMemory();
+    if (!memory) {
+      continue;
+    }
+    const FreeTypeMemory::Stats& stats = memory->GetStats();
+    total.bytes += stats.bytes;
+    total.peakBytes += stats.peakBytes;
+    total.recentPeakBytes += stats.recentPeakBytes;
+    total.allocations += stats.allocations;
+    total.frees += stats.frees;
+  }
+  return total;
+}
+
+}  // namespace fonttest
@@ -0,0 +1,134 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_PARALLEL_RUNNER_H_
+#define FONTTEST_PARALLEL_RUNNER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fonttest/disk_cache.h"
+#include "fonttest/font_cache.h"
+#include "fonttest/freetype_memory.h"
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/instance_cache.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+class FontEngine;
+
+// Distributes RenderJobs over a pool of worker threads. FreeType libraries
+// must not be shared between threads, so every worker creates its own
+// FontEngine (and with it, its own FT_Library and font cache).
+//
+// Results are delivered to the callback in the order in which jobs were
+// added, no matter in which order the workers complete them. Callbacks
+// are serialized, so the callback needs no locking of its own.
+class ParallelRunner {
+ public:
+  typedef std::function<void(const RenderJob& job,
+                             const RenderResult& result)> ResultCallback;
+
+  // Creates |numThreads| workers; zero means one per hardware thread.
+  // Check IsValid() afterwards, since the engine name may be unknown.
+  ParallelRunner(const std::string& engineName, int numThreads);
+  ~ParallelRunner();
+
+  bool IsValid() const { return !workers_.empty(); }
+  size_t GetNumThreads() const { return workers_.size(); }
+  void SetFontCacheCapacity(size_t capacity);
+  void SetOutlineCacheMaxBytes(size_t maxBytes);
+  void SetOutputFormat(OutputFormat format, bool withOutlines);
+  void SetMemoryStatsOutput(std::ostream* output);
+  void SetCanonicalSVG(bool canonical);
+
+  // Gives every worker a DiskCache in |directory|.
+  void SetDiskCacheDirectory(const std::string& directory);
+
+  void Start(const ResultCallback& callback);
+
+  // Queues a job for rendering. Blocks while too many jobs are queued,
+  // or too many results are held back for a slow job before them, so
+  // that arbitrarily long inputs are processed in bounded memory.
+  void Add(const RenderJob& job);
+
+  // Queues a job that is already known to have failed, for example
+  // because its input record was malformed. Its result is delivered
+  // in order like any other.
+  void AddFailed(const RenderJob& job, const std::string& error);
+
+  // Waits until all queued jobs have been delivered to the callback,
+  // and stops the workers.
+  void Finish();
+
+  FontCache::Stats GetFontCacheStats() const;
+  OutlineCache::Stats GetOutlineCacheStats() const;
+  DiskCache::Stats GetDiskCacheStats() const;
+  InstanceCacheStats GetInstanceCacheStats() const;
+
+  // Summed over all workers; the peaks are the sum of per-worker peaks.
+  FreeTypeMemory::Stats GetFreeTypeMemoryStats() const;
+
+ private:
+  struct Task {
+    size_t sequence;
+    RenderJob job;
+    bool failed;
+    std::string error;
+  };
+
+  struct Worker {
+    std::unique_ptr<FontEngine> engine;
+    std::unique_ptr<Renderer> renderer;
+    std::unique_ptr<DiskCache> diskCache;
+    std::thread thread;
+  };
+
+  void Enqueue(const Task& task);
+  void WorkerLoop(Worker* worker);
+  void Deliver(size_t sequence, const RenderJob& job,
+               const RenderResult& result);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  ResultCallback callback_;
+
+  std::mutex queueMutex_;
+  std::condition_variable queueNotEmpty_, queueNotFull_;
+  std::deque<Task> queue_;
+  size_t maxQueueSize_;
+  size_t maxPending_;  // jobs added but not yet delivered
+  size_t nextSequence_;
+  bool inputDone_;
+
+  // Completed results waiting for their predecessors.
+  std::mutex deliveryMutex_;
+  std::map<size_t, std::pair<RenderJob, RenderResult> > completed_;
+  std::atomic<size_t> nextToDeliver_;  // also read by Enqueue()
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_PARALLEL_RUNNER_H_
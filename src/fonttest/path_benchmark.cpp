@@ -0,0 +1,147 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fonttest/benchmark.h"
+#include "fonttest/svg_compare.h"
+#include "fonttest/svg_path_writer.h"
+
+namespace fonttest {
+
+namespace {
+
+// A path segment in font units; resembles what a large CFF glyph
+// (for example, a CJK ideograph) decomposes into.
+struct Segment {
+  char command;  // 'M', 'L', 'Q' or 'C'
+  long coords[6];
+};
+
+static std::vector<Segment> MakeSegments(size_t numSegments) {
+  std::vector<Segment> segments;
+  uint32_t random = 12345;
+  for (size_t i = 0; i < numSegments; ++i) {
+    Segment segment;
+    if (i % 40 == 0) {
+      segment.command = 'M';
+    } else {
+      static const char kCommands[] = {'L', 'C', 'C', 'Q'};
+      segment.command = kCommands[i % 4];
+    }
+    for (int j = 0; j < 6; ++j) {
+      random = random * 1103515245 + 12345;
+      segment.coords[j] = static_cast<long>((random >> 8) % 2400) - 400;
+    }
+    segments.push_back(segment);
+  }
+  return segments;
+}
+
+// How FreeTypePathConverter used to format paths, for comparison.
+static void FormatWithSnprintf(const std::vector<Segment>& segments,
+                               std::string* path) {
+  path->clear();
+  char buffer[200];
+  for (const Segment& s : segments) {
+    const char* separator = path->empty() ? "" : " ";
+    switch (s.command) {
+    case 'M':
+    case 'L':
+      snprintf(buffer, sizeof(buffer), "%s%c%ld,%ld",
+               separator, s.command, s.coords[0], s.coords[1]);
+      break;
+    case 'Q':
+      snprintf(buffer, sizeof(buffer), "%sQ%ld,%ld %ld,%ld", separator,
+               s.coords[0], s.coords[1], s.coords[2], s.coords[3]);
+      break;
+    default:
+      snprintf(buffer, sizeof(buffer), "%sC%ld,%ld %ld,%ld %ld,%ld",
+               separator, s.coords[0], s.coords[1], s.coords[2],
+               s.coords[3], s.coords[4], s.coords[5]);
+      break;
+    }
+    path->append(buffer);
+  }
+  path->append(" Z");
+}
+
+static void FormatWithWriter(const std::vector<Segment>& segments,
+                             std::string* path) {
+  path->clear();
+  SVGPathWriter writer(path);
+  for (const Segment& s : segments) {
+    const long* c = s.coords;
+    switch (s.command) {
+    case 'M':
+      writer.MoveTo(c[0], c[1]);
+      break;
+    case 'L':
+      writer.LineTo(c[0], c[1]);
+      break;
+    case 'Q':
+      writer.QuadTo(c[0], c[1], c[2], c[3]);
+      break;
+    default:
+      writer.CurveTo(c[0], c[1], c[2], c[3], c[4], c[5]);
+      break;
+    }
+  }
+  writer.ClosePath();
+}
+
+}  // namespace
+
+void RunPathBenchmarks(BenchmarkRunner* runner) {
+  const std::vector<Segment> segments = MakeSegments(400);
+  std::string expected, actual;
+  FormatWithSnprintf(segments, &expected);
+  FormatWithWriter(segments, &actual);
+  if (actual != expected) {
+    std::cerr << "SVGPathWriter output differs from snprintf()" << std::endl;
+    exit(1);
+  }
+
+  std::string path;
+  path.reserve(expected.size());
+  runner->Run("path/snprintf/400_segments", segments.size(), [&]() {
+    FormatWithSnprintf(segments, &path);
+    runner->Consume(path.size());
+  });
+  runner->Run("path/SVGPathWriter/400_segments", segments.size(), [&]() {
+    FormatWithWriter(segments, &path);
+    runner->Consume(path.size());
+  });
+
+  // Every coordinate off by one, which is still within tolerance.
+  std::vector<Segment> shifted(segments);
+  for (Segment& segment : shifted) {
+    for (long& coord : segment.coords) {
+      coord += 1;
+    }
+  }
+  std::string observed;
+  FormatWithWriter(shifted, &observed);
+  runner->Run("path/IsSimilarPath/400_segments", segments.size(), [&]() {
+    runner->Consume(IsSimilarPath(expected, observed, 1.0, NULL));
+  });
+}
+
+}  // namespace fonttest
@@ -0,0 +1,308 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef __linux__
+#  include <linux/perf_event.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fonttest/perf_counters.h"
+
+namespace fonttest {
+
+namespace {
+
+const char* const kStageNames[kNumPerfStages] = {
+  "load_font", "variation", "shaping", "outlines", "serialize",
+};
+
+const char* const kCounterNames[kNumPerfCounters] = {
+  "task-clock", "cycles", "instructions", "cache-misses", "branch-misses",
+};
+
+const int kMaxDepth = 16;
+
+struct ThreadCounters {
+  ThreadCounters() : leader(-1), numInGroup(0), depth(0) {
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      groupIndex[i] = -1;
+      last[i] = 0;
+    }
+  }
+
+  int leader;                          // file descriptor of the group
+  int groupIndex[kNumPerfCounters];    // position in a group read, or -1
+  int numInGroup;
+  PerfStage stack[kMaxDepth];
+  int depth;
+  uint64_t last[kNumPerfCounters];
+
+  std::mutex mutex;  // guards |totals| against Report()
+  PerfCounts totals;
+};
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadCounters> > threads;  // kept until exit
+std::vector<std::pair<std::string, PerfCounts> > testcases;
+bool available[kNumPerfCounters];
+thread_local ThreadCounters* threadCounters = NULL;
+
+#ifdef __linux__
+int OpenCounter(PerfCounter counter, int groupFD) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  switch (counter) {
+    case kPerfTaskClock:
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_TASK_CLOCK;
+      break;
+    case kPerfCycles:
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case kPerfInstructions:
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case kPerfCacheMisses:
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    default:
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+  }
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0 /* self */,
+                                  -1 /* any cpu */, groupFD, 0));
+}
+#endif  // __linux__
+
+// Opens the counters of the calling thread, on first use.
+ThreadCounters* GetThreadCounters() {
+  if (threadCounters) {
+    return threadCounters;
+  }
+
+  std::unique_ptr<ThreadCounters> counters(new ThreadCounters);
+#ifdef __linux__
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    const int fd = OpenCounter(static_cast<PerfCounter>(i), counters->leader);
+    if (fd < 0) {
+      continue;
+    }
+    if (counters->leader < 0) {
+      counters->leader = fd;
+    }
+    counters->groupIndex[i] = counters->numInGroup++;
+  }
+#endif  // __linux__
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  threadCounters = counters.get();
+  threads.push_back(std::move(counters));
+  return threadCounters;
+}
+
+void ReadCounters(const ThreadCounters& counters,
+                  uint64_t values[kNumPerfCounters]) {
+  uint64_t buffer[1 + kNumPerfCounters] = {0};
+#ifdef __linux__
+  if (counters.leader >= 0 &&
+      read(counters.leader, buffer, sizeof(buffer)) < 0) {
+    buffer[0] = 0;
+  }
+#endif  // __linux__
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    const int index = counters.groupIndex[i];
+    values[i] = (index >= 0 && static_cast<uint64_t>(index) < buffer[0])
+        ? buffer[1 + index] : 0;
+  }
+}
+
+// Charges the events since the last reading to the innermost stage.
+void Attribute(ThreadCounters* counters) {
+  uint64_t now[kNumPerfCounters];
+  ReadCounters(*counters, now);
+  if (counters->depth > 0) {
+    const PerfStage stage =
+        counters->stack[std::min(counters->depth, kMaxDepth) - 1];
+    std::lock_guard<std::mutex> lock(counters->mutex);
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      counters->totals.values[stage][i] += now[i] - counters->last[i];
+    }
+  }
+  memcpy(counters->last, now, sizeof(now));
+}
+
+void PrintRow(const std::string& label, const char* stage,
+              const uint64_t values[kNumPerfCounters], std::ostream* output) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%-24s %-10s", label.c_str(), stage);
+  *output << buffer;
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    if (available[i]) {
+      snprintf(buffer, sizeof(buffer), " %14llu",
+               static_cast<unsigned long long>(values[i]));
+    } else {
+      snprintf(buffer, sizeof(buffer), " %14s", "-");
+    }
+    *output << buffer;
+  }
+  if (available[kPerfCycles] && available[kPerfInstructions] &&
+      values[kPerfCycles] > 0) {
+    snprintf(buffer, sizeof(buffer), " %6.2f",
+             static_cast<double>(values[kPerfInstructions]) /
+             values[kPerfCycles]);
+    *output << buffer;
+  }
+  *output << std::endl;
+}
+
+void PrintCounts(const std::string& label, const PerfCounts& counts,
+                 bool skipEmpty, std::ostream* output) {
+  uint64_t all[kNumPerfCounters] = {0};
+  for (int stage = 0; stage < kNumPerfStages; ++stage) {
+    bool empty = true;
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      all[i] += counts.values[stage][i];
+      empty = empty && counts.values[stage][i] == 0;
+    }
+    if (!empty || !skipEmpty) {
+      PrintRow(label, kStageNames[stage], counts.values[stage], output);
+    }
+  }
+  PrintRow(label, "all", all, output);
+}
+
+}  // namespace
+
+PerfCounts::PerfCounts() {
+  memset(values, 0, sizeof(values));
+}
+
+void PerfCounts::Add(const PerfCounts& other) {
+  for (int stage = 0; stage < kNumPerfStages; ++stage) {
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      values[stage][i] += other.values[stage][i];
+    }
+  }
+}
+
+void PerfCounts::Subtract(const PerfCounts& other) {
+  for (int stage = 0; stage < kNumPerfStages; ++stage) {
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      values[stage][i] -= other.values[stage][i];
+    }
+  }
+}
+
+std::atomic<bool> PerfCounters::enabled_(false);
+
+bool PerfCounters::Start(std::string* error) {
+#ifdef __linux__
+  const ThreadCounters* counters = GetThreadCounters();
+  if (counters->leader < 0) {
+    *error = std::string("perf_event_open() failed: ") + strerror(errno);
+    return false;
+  }
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    available[i] = counters->groupIndex[i] >= 0;
+  }
+  enabled_.store(true);
+  return true;
+#else
+  *error = "perf counters are only supported on Linux";
+  return false;
+#endif  // __linux__
+}
+
+void PerfCounters::EnterStage(PerfStage stage) {
+  ThreadCounters* counters = GetThreadCounters();
+  Attribute(counters);
+  if (counters->depth < kMaxDepth) {
+    counters->stack[counters->depth] = stage;
+  }
+  ++counters->depth;
+}
+
+void PerfCounters::LeaveStage() {
+  ThreadCounters* counters = GetThreadCounters();
+  Attribute(counters);
+  --counters->depth;
+}
+
+void PerfCounters::GetThreadCounts(PerfCounts* counts) {
+  ThreadCounters* counters = GetThreadCounters();
+  std::lock_guard<std::mutex> lock(counters->mutex);
+  *counts = counters->totals;
+}
+
+void PerfCounters::AddTestcase(const std::string& id,
+                               const PerfCounts& counts) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  testcases.push_back(std::make_pair(id, counts));
+}
+
+void PerfCounters::Report(std::ostream* output) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  char header[256];
+  snprintf(header, sizeof(header), "%-24s %-10s %14s %14s %14s %14s %14s %6s",
+           "testcase", "stage", kCounterNames[0], kCounterNames[1],
+           kCounterNames[2], kCounterNames[3], kCounterNames[4], "IPC");
+  *output << header << std::endl;
+  for (const auto& testcase : testcases) {
+    PrintCounts(testcase.first, testcase.second, true, output);
+  }
+
+  PerfCounts total;
+  for (const auto& counters : threads) {
+    std::lock_guard<std::mutex> threadLock(counters->mutex);
+    total.Add(counters->totals);
+  }
+  PrintCounts("total", total, false, output);
+}
+
+PerfTestcase::PerfTestcase(const std::string& id)
+  : enabled_(PerfCounters::IsEnabled()) {
+  if (enabled_) {
+    id_ = id;
+    PerfCounters::GetThreadCounts(&start_);
+  }
+}
+
+PerfTestcase::~PerfTestcase() {
+  if (enabled_) {
+    PerfCounts counts;
+    PerfCounters::GetThreadCounts(&counts);
+    counts.Subtract(start_);
+    PerfCounters::AddTestcase(id_, counts);
+  }
+}
+
+}  // namespace fonttest
@@ -0,0 +1,120 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_PERF_COUNTERS_H_
+#define FONTTEST_PERF_COUNTERS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace fonttest {
+
+// The stages of a render that --perf-counters tells apart.
+enum PerfStage {
+  kPerfStageLoadFont,
+  kPerfStageVariation,  // setting up size and variation of a face
+  kPerfStageShaping,
+  kPerfStageOutlines,   // decomposing glyph outlines into SVG paths
+  kPerfStageSerialize,  // writing the SVG document, without outlines
+  kNumPerfStages
+};
+
+enum PerfCounter {
+  kPerfTaskClock,  // nanoseconds on the CPU
+  kPerfCycles,
+  kPerfInstructions,
+  kPerfCacheMisses,
+  kPerfBranchMisses,
+  kNumPerfCounters
+};
+
+struct PerfCounts {
+  PerfCounts();
+  void Add(const PerfCounts& other);
+  void Subtract(const PerfCounts& other);
+
+  uint64_t values[kNumPerfStages][kNumPerfCounters];
+};
+
+// Counts CPU events per render stage with Linux perf_event_open(2).
+// Every thread reads its own counters; nested stages are exclusive,
+// so the outlines converted while serializing are not counted twice.
+// Counters that the machine does not have, such as hardware counters
+// in many virtual machines, are reported as unavailable.
+class PerfCounters {
+ public:
+  // Returns false if counting is not possible at all.
+  static bool Start(std::string* error);
+  static bool IsEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Prints the counts of every testcase, followed by the totals of
+  // all threads. Call after worker threads have finished.
+  static void Report(std::ostream* output);
+
+ private:
+  friend class PerfScope;
+  friend class PerfTestcase;
+
+  static void EnterStage(PerfStage stage);
+  static void LeaveStage();
+  static void GetThreadCounts(PerfCounts* counts);
+  static void AddTestcase(const std::string& id, const PerfCounts& counts);
+
+  static std::atomic<bool> enabled_;
+};
+
+// Attributes the events between construction and destruction to a stage.
+class PerfScope {
+ public:
+  explicit PerfScope(PerfStage stage) : enabled_(PerfCounters::IsEnabled()) {
+    if (enabled_) {
+      PerfCounters::EnterStage(stage);
+    }
+  }
+  ~PerfScope() {
+    if (enabled_) {
+      PerfCounters::LeaveStage();
+    }
+  }
+
+ private:
+  PerfScope(const PerfScope&);
+  void operator=(const PerfScope&);
+
+  bool enabled_;
+};
+
+// Collects the counts of one testcase for the per-testcase report.
+class PerfTestcase {
+ public:
+  explicit PerfTestcase(const std::string& id);
+  ~PerfTestcase();
+
+ private:
+  PerfTestcase(const PerfTestcase&);
+  void operator=(const PerfTestcase&);
+
+  bool enabled_;
+  std::string id_;
+  PerfCounts start_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_PERF_COUNTERS_H_
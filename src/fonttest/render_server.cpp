@@ -0,0 +1,315 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "fonttest/batch_runner.h"
+#include "fonttest/font_cache.h"
+#include "fonttest/font_engine.h"
+#include "fonttest/json.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/render_server.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+// Responses that are waiting for a slow client; beyond this, the server
+// stops reading the client's requests until it catches up.
+static const size_t kMaxPendingOutput = 16 * 1024 * 1024;
+
+// A client connection, with a reader thread for its requests and a
+// writer thread for its responses. Workers only append to |output|, so
+// a client that does not read its responses stalls its own connection
+// rather than the workers. The socket is closed when the last reference
+// goes away, which is after the client has stopped sending and all of
+// its requests have been answered.
+struct RenderServer::Connection {
+  explicit Connection(int fd)
+    : fd(fd), broken(false), readerDone(false), pendingRequests(0) {}
+  ~Connection() { close(fd); }
+
+  // Called by the workers. Once the client has gone away, responses
+  // are dropped.
+  void Send(const std::string& data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!broken) {
+      output.append(data);
+    }
+    --pendingRequests;
+    changed.notify_all();
+  }
+
+  const int fd;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::string output;  // not yet written
+  bool broken;
+  bool readerDone;
+  size_t pendingRequests;
+};
+
+RenderServer::RenderServer(const std::string& defaultEngine, int numThreads)
+  : defaultEngine_(defaultEngine), fontCacheCapacity_(0),
+    outlineCacheMaxBytes_(0), numThreads_(0), listenFD_(-1),
+    maxQueueSize_(0) {
+  if (numThreads <= 0) {
+    numThreads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  numThreads_ = numThreads > 0 ? static_cast<size_t>(numThreads) : 1;
+  maxQueueSize_ = 4 * numThreads_;
+}
+
+RenderServer::~RenderServer() {
+  if (listenFD_ >= 0) {
+    close(listenFD_);
+  }
+}
+
+void RenderServer::SetFontCacheCapacity(size_t capacity) {
+  fontCacheCapacity_ = capacity;
+}
+
+void RenderServer::SetOutlineCacheMaxBytes(size_t maxBytes) {
+  outlineCacheMaxBytes_ = maxBytes;
+}
+
+bool RenderServer::Listen(const std::string& socketPath, std::string* error) {
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+    *error = "invalid socket path: " + socketPath;
+    return false;
+  }
+  memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+  struct stat info;
+  if (stat(socketPath.c_str(), &info) == 0) {
+    if (!S_ISSOCK(info.st_mode)) {
+      *error = "not a socket: " + socketPath;
+      return false;
+    }
+    unlink(socketPath.c_str());
+  }
+
+  listenFD_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFD_ < 0 ||
+      bind(listenFD_, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listenFD_, SOMAXCONN) != 0) {
+    *error = socketPath + ": " + strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+void RenderServer::Run() {
+  // A client that disconnects before reading its responses must not
+  // kill the server.
+  signal(SIGPIPE, SIG_IGN);
+
+  for (size_t i = 0; i < numThreads_; ++i) {
+    workers_.push_back(std::thread(&RenderServer::WorkerLoop, this));
+  }
+
+  while (true) {
+    const int fd = accept(listenFD_, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      std::cerr << "accept() failed: " << strerror(errno) << std::endl;
+      exit(1);
+    }
+    std::shared_ptr<Connection> connection(new Connection(fd));
+    std::thread(&RenderServer::ReadRequests, this, connection).detach();
+    std::thread(&RenderServer::WriteResponses, connection).detach();
+  }
+}
+
+void RenderServer::ReadRequests(std::shared_ptr<Connection> connection) {
+  std::string pending;
+  char buffer[65536];
+  while (true) {
+    const ssize_t numRead = read(connection->fd, buffer, sizeof(buffer));
+    if (numRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (numRead <= 0) {
+      break;
+    }
+    pending.append(buffer, static_cast<size_t>(numRead));
+
+    size_t start = 0, end;
+    while ((end = pending.find('\n', start)) != std::string::npos) {
+      {
+        std::unique_lock<std::mutex> lock(connection->mutex);
+        connection->changed.wait(lock, [&connection] {
+          return connection->output.size() < kMaxPendingOutput ||
+              connection->broken;
+        });
+        if (connection->broken) {
+          break;
+        }
+        ++connection->pendingRequests;
+      }
+      AddRequest(connection, pending.substr(start, end - start));
+      start = end + 1;
+    }
+    pending.erase(0, start);
+  }
+
+  std::lock_guard<std::mutex> lock(connection->mutex);
+  connection->readerDone = true;
+  connection->changed.notify_all();
+}
+
+void RenderServer::WriteResponses(std::shared_ptr<Connection> connection) {
+  std::string writing;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(connection->mutex);
+      connection->changed.wait(lock, [&connection] {
+        return !connection->output.empty() || connection->broken ||
+            (connection->readerDone && connection->pendingRequests == 0);
+      });
+      if (connection->output.empty() || connection->broken) {
+        return;
+      }
+      writing.swap(connection->output);
+      connection->changed.notify_all();  // the reader may wait for space
+    }
+
+    const char* start = writing.data();
+    size_t remaining = writing.size();
+    while (remaining > 0) {
+      const ssize_t written = write(connection->fd, start, remaining);
+      if (written < 0 && errno == EINTR) {
+        continue;
+      }
+      if (written < 0) {
+        // Wake up the reader, which has nobody left to answer.
+        shutdown(connection->fd, SHUT_RDWR);
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->broken = true;
+        connection->output.clear();
+        connection->changed.notify_all();
+        return;
+      }
+      start += written;
+      remaining -= static_cast<size_t>(written);
+    }
+    writing.clear();
+  }
+}
+
+void RenderServer::AddRequest(const std::shared_ptr<Connection>& connection,
+                              const std::string& line) {
+  if (line.find_first_not_of(" \t\r") == std::string::npos) {
+    return;
+  }
+
+  Request request;
+  request.connection = connection;
+  request.engineName = defaultEngine_;
+  request.format = kFormatSVG;
+  JSONRecord record;
+  std::string error;
+  if (!BatchRunner::ParseJob(line, &request.job, &record, &error)) {
+    request.error = "malformed request: " + error;
+  } else {
+    if (!record["engine"].empty()) {
+      request.engineName = record["engine"];
+    }
+    if (!ParseOutputFormat(record["format"], &request.format) ||
+        request.format == kFormatGlyphsBinary) {
+      request.error = "unsupported format: " + record["format"];
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(queueMutex_);
+  queueNotFull_.wait(lock, [this] { return queue_.size() < maxQueueSize_; });
+  queue_.push_back(request);
+  queueNotEmpty_.notify_one();
+}
+
+void RenderServer::WorkerLoop() {
+  // Engines are created on first use, since most servers will only
+  // ever be asked for one of them.
+  std::map<std::string, std::unique_ptr<FontEngine> > engines;
+  std::map<std::string, std::unique_ptr<Renderer> > renderers;
+  RenderResult result;
+  std::string formatted;
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex_);
+      queueNotEmpty_.wait(lock, [this] { return !queue_.empty(); });
+      request = queue_.front();
+      queue_.pop_front();
+    }
+    queueNotFull_.notify_one();
+
+    result.ok = false;
+    result.error = request.error;
+    result.output.clear();
+    if (request.error.empty()) {
+      std::unique_ptr<Renderer>& renderer = renderers[request.engineName];
+      if (!renderer) {
+        std::unique_ptr<FontEngine>& engine = engines[request.engineName];
+        engine.reset(FontEngine::Create(request.engineName));
+        if (engine) {
+          if (fontCacheCapacity_ > 0) {
+            engine->GetFontCache()->SetCapacity(fontCacheCapacity_);
+          }
+          OutlineCache* outlineCache = engine->GetOutlineCache();
+          if (outlineCache && outlineCacheMaxBytes_ > 0) {
+            outlineCache->SetMaxBytes(outlineCacheMaxBytes_);
+          }
+          renderer.reset(new Renderer(engine.get()));
+        }
+      }
+      if (renderer) {
+        renderer->SetOutputFormat(request.format, false);
+        renderer->Render(request.job, &result);
+      } else {
+        renderers.erase(request.engineName);
+        engines.erase(request.engineName);
+        result.error = "unknown engine: " + request.engineName;
+      }
+    }
+
+    formatted.clear();
+    BatchRunner::FormatResult(request.job, result, request.format,
+                              &formatted);
+    request.connection->Send(formatted);
+  }
+}
+
+}  // namespace fonttest
@@ -0,0 +1,103 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_RENDER_SERVER_H_
+#define FONTTEST_RENDER_SERVER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+// Answers render requests on a Unix domain socket, so that tools which
+// render text on demand pay for process startup and font loading only
+// once. Requests and responses are JSON Lines, one record per line, in
+// the format of BatchRunner, with two optional request fields:
+//
+//   {"id": "sample-1", "font": "/fonts/Foo.otf", "render": "Text",
+//    "variation": "wght:700", "textLanguage": "en",
+//    "engine": "TehreerStack", "format": "glyphs"}
+//
+// "engine" defaults to the server's engine, and "format" to "svg".
+// Clients may send many requests without waiting for responses, and
+// may open several connections. Requests are rendered concurrently on
+// a pool of worker threads, so responses come back in the order in
+// which they complete; clients match them to requests by "id".
+//
+// Like ParallelRunner, every worker has its own FontEngine for every
+// engine it has been asked for, with its own font and outline caches.
+// Responses are written by a thread of their connection, so workers
+// never wait for a client. A client that stops reading its responses
+// only stalls its own connection: once 16 MB of responses are waiting,
+// the server stops reading its requests.
+class RenderServer {
+ public:
+  // Creates |numThreads| workers; zero means one per hardware thread.
+  RenderServer(const std::string& defaultEngine, int numThreads);
+  ~RenderServer();
+
+  // Applied to every engine that workers create; zero keeps the default.
+  void SetFontCacheCapacity(size_t capacity);
+  void SetOutlineCacheMaxBytes(size_t maxBytes);
+
+  // Binds to |socketPath|, replacing a stale socket left behind by an
+  // earlier server, but not any other kind of file.
+  bool Listen(const std::string& socketPath, std::string* error);
+
+  // Accepts connections until the process gets killed.
+  void Run();
+
+ private:
+  struct Connection;
+
+  struct Request {
+    std::shared_ptr<Connection> connection;
+    RenderJob job;
+    std::string engineName;
+    OutputFormat format;
+    std::string error;  // set if the request could not be parsed
+  };
+
+  void ReadRequests(std::shared_ptr<Connection> connection);
+  static void WriteResponses(std::shared_ptr<Connection> connection);
+  void AddRequest(const std::shared_ptr<Connection>& connection,
+                  const std::string& line);
+  void WorkerLoop();
+
+  const std::string defaultEngine_;
+  size_t fontCacheCapacity_;
+  size_t outlineCacheMaxBytes_;
+  size_t numThreads_;
+  int listenFD_;
+  std::vector<std::thread> workers_;
+
+  std::mutex queueMutex_;
+  std::condition_variable queueNotEmpty_, queueNotFull_;
+  std::deque<Request> queue_;
+  size_t maxQueueSize_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_RENDER_SERVER_H_
@@ -0,0 +1,229 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fonttest/disk_cache.h"
+#include "fonttest/font.h"
+#include "fonttest/font_engine.h"
+#include "fonttest/freetype_memory.h"
+#include "fonttest/glyph_run.h"
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/perf_counters.h"
+#include "fonttest/renderer.h"
+#include "fonttest/svg_compare.h"
+#include "fonttest/trace.h"
+
+namespace fonttest {
+
+static void TrimWhitespace(std::string* str);
+static void SplitString(const std::string& text, char sep,
+                        std::vector<std::string>* result);
+
+const double Renderer::kFontSize = 1000.0;
+
+bool ParseVariationSpec(const std::string& spec, FontVariation* variation) {
+  if (spec.empty()) {
+    return true;
+  }
+
+  std::vector<std::string> v;
+  SplitString(spec, ';', &v);
+  for (const std::string& item : v) {
+    std::vector<std::string> keyValue;
+    SplitString(item, ':', &keyValue);
+    if (keyValue.size() != 2) {
+      return false;
+    }
+    std::string key = keyValue[0];
+    std::string value = keyValue[1];
+    TrimWhitespace(&key);
+    TrimWhitespace(&value);
+    (*variation)[key] = std::atof(value.c_str());
+  }
+  return true;
+}
+
+Renderer::Renderer(FontEngine* engine)
+  : engine_(engine), format_(kFormatSVG), withOutlines_(false),
+    canonical_(false), memoryStats_(NULL), diskCache_(NULL) {
+}
+
+Renderer::~Renderer() {
+}
+
+void Renderer::SetOutputFormat(OutputFormat format, bool withOutlines) {
+  format_ = format;
+  withOutlines_ = withOutlines;
+}
+
+void Renderer::SetDiskCache(DiskCache* diskCache) {
+  diskCache_ = diskCache;
+  if (diskCache_ && engineVersion_.empty()) {
+    engineVersion_ = engine_->GetName() + " " + engine_->GetVersion();
+  }
+}
+
+bool Renderer::Render(const RenderJob& job, RenderResult* result) {
+  TraceTestcase traceTestcase(job.id);
+  PerfTestcase perfTestcase(job.id);
+  TraceSpan span("Renderer::Render");
+  result->ok = false;
+  result->error.clear();
+  result->output.clear();
+  result->hash = 0;
+
+  if (job.variationSpec != variationSpec_) {
+    FontVariation fontVariation;
+    if (!ParseVariationSpec(job.variationSpec, &fontVariation)) {
+      result->error = "malformed variation: " + job.variationSpec;
+      return false;
+    }
+    fontVariation_.swap(fontVariation);
+    variationSpec_ = job.variationSpec;
+  }
+
+  const bool canonical = canonical_ && format_ == kFormatSVG;
+  std::string cacheKey;
+  if (LookupCached(job, &cacheKey, result)) {
+    return true;
+  }
+
+  FreeTypeMemory* memory =
+      memoryStats_ ? engine_->GetFreeTypeMemory() : NULL;
+  FreeTypeMemory::Stats beforeLoad, beforeRender;
+  if (memory) {
+    beforeLoad = memory->GetStats();
+  }
+
+  std::shared_ptr<Font> font =
+      engine_->GetCachedFont(job.fontPath, job.faceIndex);
+  if (!font) {
+    result->error = "failed to load font: " + job.fontPath;
+    return false;
+  }
+
+  if (memory) {
+    memory->ResetRecentPeak();
+    beforeRender = memory->GetStats();
+  }
+  bool ok = RenderFont(job, font.get(), fontVariation_, result);
+  if (memory) {
+    PrintFreeTypeMemoryUsage(job.id, beforeLoad, beforeRender,
+                             memory->GetStats(), memoryStats_);
+  }
+  if (ok && canonical) {
+    std::string error;
+    if (CanonicalizeSVG(result->output, &canonicalSVG_, &error)) {
+      result->output.swap(canonicalSVG_);
+      result->hash = HashCanonicalSVG(result->output);
+    } else {
+      result->error = "malformed SVG output: " + error;
+      result->ok = ok = false;
+    }
+  }
+  if (ok && !cacheKey.empty()) {
+    diskCache_->Store(cacheKey, result->output);
+  }
+  return ok;
+}
+
+bool Renderer::LookupCached(const RenderJob& job, RenderResult* result) {
+  result->ok = false;
+  result->error.clear();
+  result->output.clear();
+  result->hash = 0;
+  std::string cacheKey;
+  return LookupCached(job, &cacheKey, result);
+}
+
+// Sets |cacheKey| to the disk cache key of |job|, or to the empty string
+// if the job cannot be cached.
+bool Renderer::LookupCached(const RenderJob& job, std::string* cacheKey,
+                            RenderResult* result) {
+  const bool canonical = canonical_ && format_ == kFormatSVG;
+  if (!diskCache_ ||
+      !diskCache_->MakeKey(engineVersion_, job, format_, withOutlines_,
+                           canonical, cacheKey)) {
+    cacheKey->clear();
+    return false;
+  }
+  if (!diskCache_->Lookup(*cacheKey, &result->output)) {
+    return false;
+  }
+  if (canonical) {
+    result->hash = HashCanonicalSVG(result->output);
+  }
+  result->ok = true;
+  return true;
+}
+
+bool Renderer::RenderFont(const RenderJob& job, Font* font,
+                          const FontVariation& fontVariation,
+                          RenderResult* result) {
+  if (format_ == kFormatSVG) {
+    if (!engine_->RenderSVG(job.text, job.textLanguage, font,
+                            kFontSize, fontVariation, job.id,
+                            &result->output)) {
+      result->error = "rendering failed";
+      return false;
+    }
+  } else {
+    if (!engine_->RenderGlyphs(job.text, job.textLanguage, font,
+                               kFontSize, fontVariation, withOutlines_,
+                               &glyphRun_)) {
+      result->error = "rendering failed, or glyph output not supported by " +
+          engine_->GetName();
+      return false;
+    }
+    if (format_ == kFormatGlyphsJSON) {
+      AppendGlyphRunJSON(job.id, glyphRun_, &result->output);
+    } else {
+      AppendGlyphRunBinary(job.id, glyphRun_, &result->output);
+    }
+  }
+
+  result->ok = true;
+  return true;
+}
+
+void SplitString(const std::string& text, char sep,
+                 std::vector<std::string>* result) {
+  std::size_t start = 0, limit = 0;
+  while ((limit = text.find(sep, start)) != std::string::npos) {
+    result->push_back(text.substr(start, limit - start));
+    start = limit + 1;
+  }
+  result->push_back(text.substr(start));
+}
+
+void TrimWhitespace(std::string* str) {
+  static const char* whitespace = " \t\f\v\n\r";
+  const std::size_t start = str->find_first_not_of(whitespace);
+  if (start == std::string::npos) {
+    str->clear();
+    return;
+  }
+  str->substr(start).swap(*str);
+  const std::size_t end = str->find_last_not_of(whitespace);
+  if (end != std::string::npos) {
+    str->erase(end + 1);
+  }
+}
+
+}  // namespace fonttest
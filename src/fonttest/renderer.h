@@ -0,0 +1,120 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_RENDERER_H_
+#define FONTTEST_RENDERER_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+
+#include "fonttest/glyph_run.h"
+#include "fonttest/glyph_run_format.h"
+
+namespace fonttest {
+
+class DiskCache;
+class Font;
+class FontEngine;
+
+typedef std::map<std::string, double> FontVariation;  // "WGHT" -> 400.0
+
+// One testcase to render, as described by the data-fonttest-* attributes
+// of a testcase element.
+struct RenderJob {
+  RenderJob() : faceIndex(0) {}
+
+  std::string id;             // "AVAR-1/789"
+  std::string fontPath;       // "fonts/TestAVAR.ttf"
+  int faceIndex;
+  std::string text;
+  std::string textLanguage;
+  std::string variationSpec;  // "WGHT:700;WDTH:120"
+};
+
+struct RenderResult {
+  RenderResult() : ok(false), hash(0) {}
+
+  bool ok;
+  std::string error;
+  std::string output;  // in the Renderer's OutputFormat
+  uint64_t hash;  // of the canonical SVG output; 0 if not canonical
+};
+
+// Parses a variation specification such as "WGHT:700;WDTH:120".
+// Returns false if the specification is malformed.
+bool ParseVariationSpec(const std::string& spec, FontVariation* variation);
+
+// Renders jobs on a single FontEngine. Not thread-safe; a multithreaded
+// caller needs one Renderer (and one FontEngine) per thread.
+class Renderer {
+ public:
+  Renderer(FontEngine* engine);
+  ~Renderer();
+
+  static const double kFontSize;
+
+  // By default, jobs are rendered to SVG. Glyph formats fail for engines
+  // that cannot provide glyph runs.
+  void SetOutputFormat(OutputFormat format, bool withOutlines);
+  OutputFormat GetOutputFormat() const { return format_; }
+
+  // If set, SVG output is replaced by its canonical form, as written by
+  // WriteCanonicalSVG(), and results carry its hash.
+  void SetCanonicalSVG(bool canonical) { canonical_ = canonical; }
+
+  // If set, a line with the FreeType memory used for loading the font
+  // and for rendering is written to |output| for every job. Engines
+  // that do not use FreeType write nothing.
+  void SetMemoryStatsOutput(std::ostream* output) { memoryStats_ = output; }
+
+  // If set, jobs are looked up in |diskCache| before rendering, and
+  // successful renderings get stored there. Not owned.
+  void SetDiskCache(DiskCache* diskCache);
+
+  // Reusing |result| across calls lets its output buffer keep its
+  // capacity, so that rendering a cached font need not allocate.
+  bool Render(const RenderJob& job, RenderResult* result);
+
+  // Like Render(), but only looks |job| up in the disk cache. Returns
+  // false on a miss, and if there is no disk cache.
+  bool LookupCached(const RenderJob& job, RenderResult* result);
+
+ private:
+  bool LookupCached(const RenderJob& job, std::string* cacheKey,
+                    RenderResult* result);
+  bool RenderFont(const RenderJob& job, Font* font,
+                  const FontVariation& fontVariation, RenderResult* result);
+
+  FontEngine* engine_;
+  OutputFormat format_;
+  bool withOutlines_;
+  bool canonical_;
+  std::ostream* memoryStats_;
+  DiskCache* diskCache_;
+  std::string engineVersion_;  // for disk cache keys
+
+  // The most recently parsed variation. Jobs of a batch mostly share a
+  // few variations, so this saves parsing (and allocating) for each job.
+  std::string variationSpec_;
+  FontVariation fontVariation_;
+  GlyphRun glyphRun_;
+  std::string canonicalSVG_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_RENDERER_H_
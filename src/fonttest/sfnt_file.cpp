@@ -0,0 +1,136 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "fonttest/sfnt_file.h"
+
+namespace fonttest {
+
+static uint32_t ReadUInt32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) |
+         static_cast<uint32_t>(p[3]);
+}
+
+static uint16_t ReadUInt16(const uint8_t* p) {
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+std::shared_ptr<const SfntFile> SfntFile::Open(const std::string& path,
+                                               int faceIndex) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return std::shared_ptr<const SfntFile>();
+  }
+
+  struct stat st;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    data = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ,
+                MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    return std::shared_ptr<const SfntFile>();
+  }
+
+  std::shared_ptr<SfntFile> file(
+      new SfntFile(static_cast<const uint8_t*>(data),
+                   static_cast<size_t>(st.st_size)));
+  if (!file->ReadDirectory(faceIndex)) {
+    return std::shared_ptr<const SfntFile>();
+  }
+  return file;
+}
+
+SfntFile::SfntFile(const uint8_t* data, size_t size)
+  : data_(data), size_(size) {
+}
+
+SfntFile::~SfntFile() {
+  munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+bool SfntFile::ReadDirectory(int faceIndex) {
+  // Like FreeType, we take the named instance from the upper 16 bits;
+  // all instances share the tables of their face.
+  uint32_t index = static_cast<uint32_t>(faceIndex) & 0xffff;
+  size_t offset = 0;
+  if (size_ >= 12 && ReadUInt32(data_) == 0x74746366) {  // 'ttcf'
+    uint32_t numFonts = ReadUInt32(data_ + 8);
+    if (index >= numFonts || 12 + (index + 1) * 4 > size_) {
+      return false;
+    }
+    offset = ReadUInt32(data_ + 12 + index * 4);
+  } else if (index != 0) {
+    return false;
+  }
+
+  if (offset + 12 > size_) {
+    return false;
+  }
+  uint32_t version = ReadUInt32(data_ + offset);
+  if (version != 0x00010000 && version != 0x4F54544F &&  // 'OTTO'
+      version != 0x74727565) {  // 'true'
+    return false;
+  }
+
+  uint16_t numTables = ReadUInt16(data_ + offset + 4);
+  if (offset + 12 + numTables * 16 > size_) {
+    return false;
+  }
+  tables_.reserve(numTables);
+  for (uint16_t i = 0; i < numTables; ++i) {
+    const uint8_t* record = data_ + offset + 12 + i * 16;
+    Table table;
+    table.tag = ReadUInt32(record);
+    table.offset = ReadUInt32(record + 8);
+    table.length = ReadUInt32(record + 12);
+    // Tables that extend beyond the end of the file are left out, which
+    // makes them look missing, as they do to FreeType.
+    if (table.offset <= size_ && table.length <= size_ - table.offset) {
+      tables_.push_back(table);
+    }
+  }
+  std::sort(tables_.begin(), tables_.end());
+  return true;
+}
+
+bool SfntFile::GetTable(uint32_t tag, const uint8_t** data,
+                        size_t* length) const {
+  Table key;
+  key.tag = tag;
+  std::vector<Table>::const_iterator iter =
+      std::lower_bound(tables_.begin(), tables_.end(), key);
+  if (iter == tables_.end() || iter->tag != tag) {
+    return false;
+  }
+  *data = data_ + iter->offset;
+  *length = iter->length;
+  return true;
+}
+
+}  // namespace fonttest
@@ -0,0 +1,64 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_SFNT_FILE_H_
+#define FONTTEST_SFNT_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fonttest {
+
+// A font file that is memory-mapped once, with the table directory of
+// one of its faces. Tables are returned as views into the mapping, which
+// stays valid for as long as the SfntFile exists; users that need the
+// tables hold on to the shared pointer. Immutable, and thus thread-safe.
+class SfntFile {
+ public:
+  // Returns NULL if the file cannot be mapped, or if it is not a TrueType
+  // or OpenType font or collection with a face at |faceIndex|; WOFF and
+  // other formats are left to FreeType.
+  static std::shared_ptr<const SfntFile> Open(const std::string& path,
+                                              int faceIndex);
+  ~SfntFile();
+
+  // Looks up a table of the face; returns false if it has no such table.
+  bool GetTable(uint32_t tag, const uint8_t** data, size_t* length) const;
+
+ private:
+  struct Table {
+    uint32_t tag;
+    uint32_t offset;
+    uint32_t length;
+    bool operator<(const Table& other) const { return tag < other.tag; }
+  };
+
+  SfntFile(const uint8_t* data, size_t size);
+  SfntFile(const SfntFile&);
+  void operator=(const SfntFile&);
+
+  bool ReadDirectory(int faceIndex);
+
+  const uint8_t* data_;
+  size_t size_;
+  std::vector<Table> tables_;  // sorted by tag
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_SFNT_FILE_H_
@@ -0,0 +1,252 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fonttest/suite_runner.h"
+#include "fonttest/svg_compare.h"
+#include "fonttest/test_harness.h"
+#include "fonttest/xml.h"
+
+namespace fonttest {
+
+static const char kFontTestNamespace[] =
+    "{https://github.com/OpenType/fonttest}";
+
+static std::string GetFontTestAttribute(const XMLElement& element,
+                                        const char* name) {
+  const std::string* value =
+      element.GetAttribute(std::string(kFontTestNamespace) + name);
+  return value ? *value : std::string();
+}
+
+// Collects the elements whose class attribute is exactly |className|,
+// in document order, like ElementTree's findall(".//*[@class='...']").
+static void FindByClass(XMLElement* element, const std::string& className,
+                        std::vector<XMLElement*>* found) {
+  for (auto& child : element->children) {
+    const std::string* value = child->GetAttribute("class");
+    if (value && *value == className) {
+      found->push_back(child.get());
+    }
+    FindByClass(child.get(), className, found);
+  }
+}
+
+SuiteRunner::SuiteRunner(const std::string& engineName, int numThreads)
+  : runner_(engineName, numThreads) {
+  runner_.SetCanonicalSVG(true);
+}
+
+SuiteRunner::~SuiteRunner() {
+}
+
+std::string SuiteRunner::GetSortKey(const std::string& name) {
+  std::string key;
+  for (size_t i = 0; i < name.size(); ) {
+    if (name[i] < '0' || name[i] > '9') {
+      key.push_back(name[i++]);
+      continue;
+    }
+    size_t end = i;
+    while (end < name.size() && name[end] >= '0' && name[end] <= '9') {
+      ++end;
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%09lld",
+             std::atoll(name.substr(i, end - i).c_str()));
+    key.append(buffer);
+    i = end;
+  }
+  return key;
+}
+
+bool SuiteRunner::Run(const std::string& suiteDir,
+                      const std::string& fontDir, std::ostream* output) {
+  std::vector<std::pair<std::string, std::string> > files;  // key, name
+  DIR* dir = opendir(suiteDir.c_str());
+  if (!dir) {
+    std::cerr << "failed to open test suite: " << suiteDir << std::endl;
+    exit(1);
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    const std::string name(entry->d_name);
+    if (name == "index.html" || name.size() < 5 ||
+        name.compare(name.size() - 5, 5, ".html") != 0) {
+      continue;
+    }
+    files.push_back(std::make_pair(GetSortKey(name), name));
+  }
+  closedir(dir);
+  std::sort(files.begin(), files.end());
+
+  conformance_.clear();
+  runner_.Start([this, output](const RenderJob& job,
+                               const RenderResult& result) {
+    CheckResult(job, result, output);
+  });
+
+  for (const auto& file : files) {
+    std::string error;
+    const std::string path = suiteDir + "/" + file.second;
+    if (!AddTestcases(path, fontDir, &error)) {
+      std::cerr << path << ": " << error << std::endl;
+      exit(1);
+    }
+  }
+  runner_.Finish();
+
+  const bool ok = HasPassed("");
+  *output << (ok ? "PASS" : "FAIL") << std::endl;
+  return ok;
+}
+
+bool SuiteRunner::AddTestcases(const std::string& path,
+                               const std::string& fontDir,
+                               std::string* error) {
+  std::ifstream input(path.c_str());
+  if (!input) {
+    *error = "cannot open file";
+    return false;
+  }
+  std::stringstream text;
+  text << input.rdbuf();
+
+  std::unique_ptr<XMLElement> doc;
+  if (!ParseXML(text.str(), &doc, error)) {
+    return false;
+  }
+
+  std::vector<XMLElement*> expected, expectedNoCrash;
+  FindByClass(doc.get(), "expected", &expected);
+  FindByClass(doc.get(), "expected-no-crash", &expectedNoCrash);
+  for (XMLElement* element : expected) {
+    AddTestcase(element, true, fontDir);
+  }
+  for (XMLElement* element : expectedNoCrash) {
+    AddTestcase(element, false, fontDir);
+  }
+  return true;
+}
+
+// Takes the expected SVG out of |element|, so the document need not be
+// kept around while the testcase is waiting for its result.
+void SuiteRunner::AddTestcase(XMLElement* element, bool checkRendering,
+                              const std::string& fontDir) {
+  RenderJob job;
+  job.id = GetFontTestAttribute(*element, "id");
+  job.fontPath = fontDir + "/" + GetFontTestAttribute(*element, "font");
+  job.text = GetFontTestAttribute(*element, "render");
+  job.variationSpec = GetFontTestAttribute(*element, "var");
+
+  Testcase testcase;
+  testcase.id = job.id;
+  if (checkRendering) {
+    for (auto& child : element->children) {
+      if (child->tag == "svg") {
+        testcase.expected = std::move(child);
+        NormalizeSVG(testcase.expected.get());
+        std::string canonical;
+        WriteCanonicalSVG(*testcase.expected, &canonical);
+        testcase.expectedHash = HashCanonicalSVG(canonical);
+        break;
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pending_.push_back(std::move(testcase));
+  }
+  runner_.Add(job);
+}
+
+// Called for every result, in the order in which testcases were added.
+void SuiteRunner::CheckResult(const RenderJob& job,
+                              const RenderResult& result,
+                              std::ostream* output) {
+  Testcase testcase;
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    testcase = std::move(pending_.front());
+    pending_.pop_front();
+  }
+
+  bool ok = result.ok;
+  SVGDifference difference;
+  std::string error = result.error;
+  if (ok && testcase.expected && result.hash != testcase.expectedHash) {
+    // Not identical, but possibly within tolerance. The output has
+    // already been normalized by the Renderer.
+    std::unique_ptr<XMLElement> observed;
+    if (ParseSVGForComparison(result.output, &observed, &error)) {
+      ok = IsSimilarSVG(*testcase.expected, *observed,
+                        TestHarness::kMaxDelta, &difference);
+    } else {
+      ok = false;
+      error = "malformed SVG output: " + error;
+    }
+  }
+
+  SetConformance(testcase.id, ok);
+  *output << (ok ? "PASS " : "FAIL ") << testcase.id << std::endl;
+  if (!ok && !result.ok) {
+    *output << "  error:    " << result.error << std::endl;
+  } else if (!ok && !difference.location.empty()) {
+    *output << "  at:       " << difference.location << std::endl
+            << "  expected: " << difference.expected << std::endl
+            << "  observed: " << difference.observed << std::endl;
+  } else if (!ok) {
+    *output << "  error:    " << error << std::endl;
+  }
+}
+
+// Like check.py, marks a testcase and all groups that contain it:
+// "GVAR-1/2" belongs to "GVAR-1" and to the empty group.
+void SuiteRunner::SetConformance(const std::string& testcase, bool ok) {
+  conformance_[testcase] = ok;
+  size_t pos = 0;
+  std::string group;
+  while (true) {
+    auto iter = conformance_.find(group);
+    const bool groupOk = (iter == conformance_.end()) || iter->second;
+    conformance_[group] = ok && groupOk;
+    pos = testcase.find('/', pos);
+    if (pos == std::string::npos) {
+      break;
+    }
+    group = testcase.substr(0, pos);
+    ++pos;
+  }
+}
+
+bool SuiteRunner::HasPassed(const std::string& group) const {
+  auto iter = conformance_.find(group);
+  return iter != conformance_.end() && iter->second;
+}
+
+}  // namespace fonttest
@@ -0,0 +1,93 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_SUITE_RUNNER_H_
+#define FONTTEST_SUITE_RUNNER_H_
+
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fonttest/parallel_runner.h"
+#include "fonttest/renderer.h"
+#include "fonttest/xml.h"
+
+namespace fonttest {
+
+// Runs the conformance test suite in a single process, like check.py
+// does it with one fonttest process per test case. Every testcases/*.html
+// file is searched for elements with class="expected" (which must render
+// similar to the SVG they contain) and class="expected-no-crash" (which
+// only need to render), described by their ft:id, ft:font, ft:render and
+// ft:var attributes. Testcases are rendered by a ParallelRunner; results
+// are checked and printed in suite order. Workers produce canonical SVG,
+// so a rendering that is identical to the expected one passes by hash,
+// without comparing coordinates.
+class SuiteRunner {
+ public:
+  SuiteRunner(const std::string& engineName, int numThreads);
+  ~SuiteRunner();
+
+  bool IsValid() const { return runner_.IsValid(); }
+  ParallelRunner* GetParallelRunner() { return &runner_; }
+
+  // Prints "PASS <id>" or "FAIL <id>" for every testcase, and finally
+  // the overall verdict. Fonts are looked up in |fontDir|. Returns true
+  // if all testcases have passed.
+  bool Run(const std::string& suiteDir, const std::string& fontDir,
+           std::ostream* output);
+
+  // Returns whether a group of testcases, such as "AVAR-1", has passed;
+  // the empty group stands for the entire suite. Valid after Run().
+  bool HasPassed(const std::string& group) const;
+
+  // Orders file names the way check.py does, so that "GVAR-10" comes
+  // after "GVAR-9".
+  static std::string GetSortKey(const std::string& name);
+
+ private:
+  struct Testcase {
+    Testcase() : expectedHash(0) {}
+
+    std::string id;
+    std::unique_ptr<XMLElement> expected;  // NULL for expected-no-crash
+    uint64_t expectedHash;  // HashCanonicalSVG() of |expected|
+  };
+
+  bool AddTestcases(const std::string& path, const std::string& fontDir,
+                    std::string* error);
+  void AddTestcase(XMLElement* element, bool checkRendering,
+                   const std::string& fontDir);
+  void CheckResult(const RenderJob& job, const RenderResult& result,
+                   std::ostream* output);
+  void SetConformance(const std::string& testcase, bool ok);
+
+  ParallelRunner runner_;
+
+  // Testcases whose results have not been delivered yet, in suite order.
+  std::mutex pendingMutex_;
+  std::deque<Testcase> pending_;
+
+  std::map<std::string, bool> conformance_;  // testcase or group -> ok
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_SUITE_RUNNER_H_
@@ -0,0 +1,644 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fonttest/svg_compare.h"
+#include "fonttest/xml.h"
+
+namespace fonttest {
+
+namespace {
+
+static const char kXLinkNamespace[] = "http://www.w3.org/1999/xlink";
+static const char kXLinkHref[] = "{http://www.w3.org/1999/xlink}href";
+
+typedef std::map<std::string, std::string> NamespacePrefixes;  // by URI
+
+// A tokenized path, as produced by parse_path() and simplified_path()
+// in svgutil.py. Token kinds and numbers are kept in separate arrays,
+// so that all coordinates can be compared in one tight loop.
+struct PathTokens {
+  std::string kinds;            // a command letter, 'n' or '?' per token
+  std::vector<double> numbers;  // the values of all 'n' tokens
+  std::vector<std::string> others;  // the text of all '?' tokens
+};
+
+enum CharClass {
+  kOther = 0, kDigit, kSeparator, kCommand, kDot, kSign
+};
+
+struct CharClassTable {
+  CharClassTable() {
+    for (int i = 0; i < 256; ++i) {
+      classes[i] = kOther;
+    }
+    for (const char* c = "0123456789eE"; *c; ++c) {
+      classes[static_cast<unsigned char>(*c)] = kDigit;
+    }
+    for (const char* c = ", \t\n\r\f\v"; *c; ++c) {
+      classes[static_cast<unsigned char>(*c)] = kSeparator;
+    }
+    for (const char* c = "MmZzLlHhVvCcSsQqTtAa"; *c; ++c) {
+      classes[static_cast<unsigned char>(*c)] = kCommand;
+    }
+    classes[static_cast<unsigned char>('.')] = kDot;
+    classes[static_cast<unsigned char>('+')] = kSign;
+    classes[static_cast<unsigned char>('-')] = kSign;
+  }
+
+  CharClass classes[256];
+};
+
+// Splits path data into tokens in a single pass. The entity splitting
+// is a port of parse_path() in svgutil.py, which in turn comes from
+// http://codereview.stackexchange.com/a/88051; like simplified_path()
+// in the same file, closed subpaths that consist of nothing but
+// "moveto" commands are dropped.
+class PathTokenizer {
+ public:
+  explicit PathTokenizer(PathTokens* tokens)
+    : tokens_(tokens), entityStart_(NULL), entityLength_(0),
+      isCopied_(false), subpathHasDrawing_(false) {
+    MarkSubpathStart();
+  }
+
+  void Tokenize(const std::string& pathData) {
+    static const CharClassTable table;
+    tokens_->kinds.reserve(pathData.size() / 2);
+    tokens_->numbers.reserve(pathData.size() / 2);
+    bool isFloat = false;
+    const char* end = pathData.data() + pathData.size();
+    for (const char* p = pathData.data(); p != end; ++p) {
+      const char c = *p;
+      const CharClass charClass = table.classes[static_cast<unsigned char>(c)];
+      if (charClass == kDigit) {
+        Append(p);
+        continue;
+      }
+      if (charClass == kOther ||
+          (charClass == kSeparator && entityLength_ == 0)) {
+        continue;
+      }
+
+      // Everything else may end the current entity.
+      bool finish = entityLength_ > 0;
+      if (charClass == kDot) {
+        finish = isFloat;
+      } else if (charClass == kSign) {
+        const char last = GetLastChar();
+        finish = finish && last != 'e' && last != 'E';
+      }
+      if (finish) {
+        FinishEntity();
+        isFloat = false;
+      }
+
+      if (charClass == kCommand) {
+        AddCommand(c);
+      } else if (charClass == kDot) {
+        Append(p);
+        isFloat = true;
+      } else if (charClass == kSign) {
+        Append(p);
+      }
+    }
+    if (entityLength_ > 0) {
+      FinishEntity();
+    }
+  }
+
+ private:
+  // Entities are usually a contiguous range of the path data; they only
+  // need to be copied if characters get dropped from their middle.
+  void Append(const char* p) {
+    if (entityLength_ == 0) {
+      entityStart_ = p;
+    } else if (!isCopied_ && p != entityStart_ + entityLength_) {
+      copy_.assign(entityStart_, entityLength_);
+      isCopied_ = true;
+    }
+    if (isCopied_) {
+      copy_.push_back(*p);
+    }
+    ++entityLength_;
+  }
+
+  char GetLastChar() const {
+    if (entityLength_ == 0) {
+      return '\0';
+    }
+    return isCopied_ ? copy_.back() : entityStart_[entityLength_ - 1];
+  }
+
+  void MarkSubpathStart() {
+    subpathKinds_ = tokens_->kinds.size();
+    subpathNumbers_ = tokens_->numbers.size();
+    subpathOthers_ = tokens_->others.size();
+    subpathHasDrawing_ = false;
+  }
+
+  void AddCommand(char command) {
+    tokens_->kinds.push_back(command);
+    if (command == 'Z' || command == 'z') {
+      if (!subpathHasDrawing_) {
+        tokens_->kinds.resize(subpathKinds_);
+        tokens_->numbers.resize(subpathNumbers_);
+        tokens_->others.resize(subpathOthers_);
+      }
+      MarkSubpathStart();
+    } else if (command != 'M' && command != 'm') {
+      subpathHasDrawing_ = true;
+    }
+  }
+
+  // Plain integers, which is what fonttest writes, take a fast path.
+  static bool ParseInteger(const char* p, size_t length, double* value) {
+    const char* end = p + length;
+    bool negative = false;
+    if (p != end && (*p == '+' || *p == '-')) {
+      negative = (*p == '-');
+      ++p;
+    }
+    if (p == end || end - p > 15) {
+      return false;
+    }
+    int64_t n = 0;
+    for (; p != end; ++p) {
+      if (*p < '0' || *p > '9') {
+        return false;
+      }
+      n = n * 10 + (*p - '0');
+    }
+    *value = static_cast<double>(negative ? -n : n);
+    return true;
+  }
+
+  // Like Python's float(), accepts the entity only if it is a number
+  // in its entirety.
+  void FinishEntity() {
+    if (!isCopied_) {
+      double value;
+      if (ParseInteger(entityStart_, entityLength_, &value)) {
+        tokens_->kinds.push_back('n');
+        tokens_->numbers.push_back(value);
+        entityLength_ = 0;
+        return;
+      }
+      copy_.assign(entityStart_, entityLength_);
+    }
+
+    const char* token = copy_.c_str();
+    char* end = NULL;
+    const double value = strtod(token, &end);
+    if (end != token && *end == '\0') {
+      tokens_->kinds.push_back('n');
+      tokens_->numbers.push_back(value);
+    } else {
+      tokens_->kinds.push_back('?');
+      tokens_->others.push_back(copy_);
+    }
+    copy_.clear();
+    entityLength_ = 0;
+    isCopied_ = false;
+  }
+
+  PathTokens* tokens_;
+  const char* entityStart_;
+  size_t entityLength_;
+  std::string copy_;  // the entity, if it is not contiguous
+  bool isCopied_;
+  size_t subpathKinds_, subpathNumbers_, subpathOthers_;
+  bool subpathHasDrawing_;
+};
+
+static void TokenizePath(const std::string& pathData, PathTokens* tokens) {
+  PathTokenizer tokenizer(tokens);
+  tokenizer.Tokenize(pathData);
+}
+
+// Returns the index of the first number pair that differs by more than
+// |maxDelta|, or |count| if there is none. Works in blocks without
+// early exit, which lets the compiler vectorize the inner loop.
+static size_t FindNumberMismatch(const double* a, const double* b,
+                                 size_t count, double maxDelta) {
+  const size_t kBlock = 16;
+  size_t i = 0;
+  for (; i + kBlock <= count; i += kBlock) {
+    int exceeded = 0;
+    for (size_t j = 0; j < kBlock; ++j) {
+      exceeded |= std::fabs(a[i + j] - b[i + j]) > maxDelta;
+    }
+    if (exceeded) {
+      break;
+    }
+  }
+  for (; i < count; ++i) {
+    if (std::fabs(a[i] - b[i]) > maxDelta) {
+      return i;
+    }
+  }
+  return count;
+}
+
+static std::string DescribeToken(const PathTokens& tokens, size_t index) {
+  if (index >= tokens.kinds.size()) {
+    return "(end of path)";
+  }
+  const char kind = tokens.kinds[index];
+  if (kind != 'n' && kind != '?') {
+    return std::string(1, kind);
+  }
+
+  size_t numberIndex = 0, otherIndex = 0;
+  for (size_t i = 0; i < index; ++i) {
+    if (tokens.kinds[i] == 'n') {
+      ++numberIndex;
+    } else if (tokens.kinds[i] == '?') {
+      ++otherIndex;
+    }
+  }
+  if (kind == '?') {
+    return tokens.others[otherIndex];
+  }
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.17g", tokens.numbers[numberIndex]);
+  return buffer;
+}
+
+static bool ComparePathTokens(const PathTokens& a, const PathTokens& b,
+                              double maxDelta, size_t* mismatch) {
+  // Token kinds must agree one by one, and so must unparseable tokens.
+  const size_t numTokens = std::min(a.kinds.size(), b.kinds.size());
+  size_t firstKindMismatch = numTokens;
+  size_t numNumbers = 0, numOthers = 0;
+  for (size_t i = 0; i < numTokens; ++i) {
+    const char kind = a.kinds[i];
+    if (kind != b.kinds[i] ||
+        (kind == '?' && a.others[numOthers] != b.others[numOthers])) {
+      firstKindMismatch = i;
+      break;
+    }
+    if (kind == 'n') {
+      ++numNumbers;
+    } else if (kind == '?') {
+      ++numOthers;
+    }
+  }
+
+  // Compare the coordinates that precede the first structural mismatch.
+  const size_t numberMismatch = FindNumberMismatch(
+      a.numbers.data(), b.numbers.data(), numNumbers, maxDelta);
+  if (numberMismatch < numNumbers) {
+    size_t seen = 0;
+    for (size_t i = 0; i < firstKindMismatch; ++i) {
+      if (a.kinds[i] == 'n' && seen++ == numberMismatch) {
+        *mismatch = i;
+        return false;
+      }
+    }
+  }
+
+  if (firstKindMismatch < numTokens || a.kinds.size() != b.kinds.size()) {
+    *mismatch = firstKindMismatch;
+    return false;
+  }
+  return true;
+}
+
+static std::string ChildLocation(const std::string& parent,
+                                 const XMLElement& child, size_t index) {
+  return parent + "/" + child.tag + "[" + std::to_string(index + 1) + "]";
+}
+
+static bool IsSimilarElement(const XMLElement* a, const XMLElement* b,
+                             double maxDelta, const std::string& location,
+                             SVGDifference* difference) {
+  if (!a || !b) {
+    if (difference) {
+      difference->location = location;
+      difference->expected = a ? "<" + a->tag + ">" : "(no element)";
+      difference->observed = b ? "<" + b->tag + ">" : "(no element)";
+    }
+    return false;
+  }
+  if (a->tag != b->tag) {
+    if (difference) {
+      difference->location = location;
+      difference->expected = "<" + a->tag + ">";
+      difference->observed = "<" + b->tag + ">";
+    }
+    return false;
+  }
+
+  for (const XMLElement::Attribute& attribute : a->attributes) {
+    const std::string& name = attribute.first;
+    const std::string* valueB = b->GetAttribute(name);
+    if (!valueB) {
+      if (difference) {
+        difference->location = location + "@" + name;
+        difference->expected = attribute.second;
+        difference->observed = "(missing)";
+      }
+      return false;
+    }
+    if (name == "d" || name == "viewBox" || name == "x" || name == "y") {
+      if (!IsSimilarPath(attribute.second, *valueB, maxDelta, difference)) {
+        if (difference) {
+          difference->location = location + "@" + name + ", " +
+              difference->location;
+        }
+        return false;
+      }
+    } else if (attribute.second != *valueB) {
+      if (difference) {
+        difference->location = location + "@" + name;
+        difference->expected = attribute.second;
+        difference->observed = *valueB;
+      }
+      return false;
+    }
+  }
+
+  const size_t numChildren = std::max(a->children.size(), b->children.size());
+  for (size_t i = 0; i < numChildren; ++i) {
+    const XMLElement* childA =
+        i < a->children.size() ? a->children[i].get() : NULL;
+    const XMLElement* childB =
+        i < b->children.size() ? b->children[i].get() : NULL;
+    const std::string childLocation =
+        ChildLocation(location, childA ? *childA : *childB, i);
+    if (!IsSimilarElement(childA, childB, maxDelta, childLocation,
+                          difference)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void CollapseWhitespace(std::string* s) {
+  std::string result;
+  bool pendingSpace = false;
+  for (char c : *s) {
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+        c == '\f' || c == '\v') {
+      pendingSpace = !result.empty();
+    } else {
+      if (pendingSpace) {
+        result.push_back(' ');
+        pendingSpace = false;
+      }
+      result.push_back(c);
+    }
+  }
+  s->swap(result);
+}
+
+static void FindPathParents(XMLElement* element,
+                            std::vector<XMLElement*>* parents) {
+  bool isParent = false;
+  for (auto& child : element->children) {
+    if (!isParent && child->tag == "path" && child->GetAttribute("d")) {
+      parents->push_back(element);
+      isParent = true;
+    }
+    FindPathParents(child.get(), parents);
+  }
+}
+
+static void RemoveChild(XMLElement* parent, const XMLElement* child) {
+  for (auto iter = parent->children.begin();
+       iter != parent->children.end(); ++iter) {
+    if (iter->get() == child) {
+      parent->children.erase(iter);
+      return;
+    }
+  }
+}
+
+// Assigns a prefix to the namespace of |name|, if it has one. Like
+// ElementTree, we call the namespaces "ns0", "ns1" and so on, except
+// for XLink, which every SVG reader knows as "xlink".
+static void AddNamespace(const std::string& name,
+                         NamespacePrefixes* prefixes) {
+  if (name.empty() || name[0] != '{') {
+    return;
+  }
+  const std::string uri = name.substr(1, name.find('}') - 1);
+  if (prefixes->count(uri)) {
+    return;
+  }
+  (*prefixes)[uri] = uri == kXLinkNamespace ?
+      std::string("xlink") : "ns" + std::to_string(prefixes->size());
+}
+
+static void CollectNamespaces(const XMLElement& element,
+                              NamespacePrefixes* prefixes) {
+  AddNamespace(element.tag, prefixes);
+  for (const XMLElement::Attribute& attribute : element.attributes) {
+    AddNamespace(attribute.first, prefixes);
+  }
+  for (const auto& child : element.children) {
+    CollectNamespaces(*child, prefixes);
+  }
+}
+
+static void AppendName(const std::string& name,
+                       const NamespacePrefixes& prefixes, std::string* out) {
+  if (name.empty() || name[0] != '{') {
+    out->append(name);
+    return;
+  }
+  const size_t end = name.find('}');
+  out->append(prefixes.find(name.substr(1, end - 1))->second);
+  out->push_back(':');
+  out->append(name, end + 1, std::string::npos);
+}
+
+static void AppendEscaped(const std::string& value, std::string* out) {
+  for (char c : value) {
+    switch (c) {
+      case '&': out->append("&amp;"); break;
+      case '<': out->append("&lt;"); break;
+      case '>': out->append("&gt;"); break;
+      case '"': out->append("&quot;"); break;
+      case '\t': out->append("&#9;"); break;
+      case '\n': out->append("&#10;"); break;
+      case '\r': out->append("&#13;"); break;
+      default: out->push_back(c); break;
+    }
+  }
+}
+
+static bool CompareAttributeNames(const XMLElement::Attribute* a,
+                                  const XMLElement::Attribute* b) {
+  return a->first < b->first;
+}
+
+static void AppendCanonicalElement(const XMLElement& element,
+                                   const NamespacePrefixes& prefixes,
+                                   bool isRoot, std::string* out) {
+  out->push_back('<');
+  AppendName(element.tag, prefixes, out);
+  if (isRoot) {
+    for (const auto& prefix : prefixes) {
+      out->append(" xmlns:");
+      out->append(prefix.second);
+      out->append("=\"");
+      AppendEscaped(prefix.first, out);
+      out->push_back('"');
+    }
+  }
+
+  std::vector<const XMLElement::Attribute*> attributes;
+  for (const XMLElement::Attribute& attribute : element.attributes) {
+    attributes.push_back(&attribute);
+  }
+  std::sort(attributes.begin(), attributes.end(), CompareAttributeNames);
+  for (const XMLElement::Attribute* attribute : attributes) {
+    out->push_back(' ');
+    AppendName(attribute->first, prefixes, out);
+    out->append("=\"");
+    AppendEscaped(attribute->second, out);
+    out->push_back('"');
+  }
+
+  if (element.children.empty()) {
+    out->append("/>");
+    return;
+  }
+  out->push_back('>');
+  for (const auto& child : element.children) {
+    AppendCanonicalElement(*child, prefixes, false, out);
+  }
+  out->append("</");
+  AppendName(element.tag, prefixes, out);
+  out->push_back('>');
+}
+
+}  // namespace
+
+void WriteCanonicalSVG(const XMLElement& svg, std::string* out) {
+  NamespacePrefixes prefixes;
+  CollectNamespaces(svg, &prefixes);
+  AppendCanonicalElement(svg, prefixes, true, out);
+}
+
+bool CanonicalizeSVG(const std::string& svg, std::string* canonical,
+                     std::string* error) {
+  std::unique_ptr<XMLElement> root;
+  if (!ParseSVGForComparison(svg, &root, error)) {
+    return false;
+  }
+  NormalizeSVG(root.get());
+  canonical->clear();
+  WriteCanonicalSVG(*root, canonical);
+  return true;
+}
+
+uint64_t HashCanonicalSVG(const std::string& canonical) {
+  uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+  for (char c : canonical) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool IsSimilarPath(const std::string& expected, const std::string& observed,
+                   double maxDelta, SVGDifference* difference) {
+  PathTokens a, b;
+  TokenizePath(expected, &a);
+  TokenizePath(observed, &b);
+  size_t mismatch = 0;
+  if (ComparePathTokens(a, b, maxDelta, &mismatch)) {
+    return true;
+  }
+  if (difference) {
+    difference->location = "token " + std::to_string(mismatch);
+    difference->expected = DescribeToken(a, mismatch);
+    difference->observed = DescribeToken(b, mismatch);
+  }
+  return false;
+}
+
+bool IsSimilarSVG(const XMLElement& expected, const XMLElement& observed,
+                  double maxDelta, SVGDifference* difference) {
+  return IsSimilarElement(&expected, &observed, maxDelta, expected.tag,
+                          difference);
+}
+
+void NormalizeSVG(XMLElement* svg) {
+  std::vector<XMLElement*> parents;
+  for (auto& child : svg->children) {
+    FindPathParents(child.get(), &parents);
+  }
+  for (auto& child : svg->children) {
+    if (child->tag == "path" && child->GetAttribute("d")) {
+      parents.insert(parents.begin(), svg);
+      break;
+    }
+  }
+
+  for (XMLElement* symbol : parents) {
+    XMLElement* path = NULL;
+    for (auto& child : symbol->children) {
+      if (child->tag == "path" && child->GetAttribute("d")) {
+        path = child.get();
+        break;
+      }
+    }
+
+    std::string d = *path->GetAttribute("d");
+    CollapseWhitespace(&d);
+    path->SetAttribute("d", d);
+    if (!d.empty()) {
+      continue;
+    }
+
+    // Drop the empty path's symbol, and the <use> elements pointing to it.
+    const std::string* id = symbol->GetAttribute("id");
+    const std::string href = "#" + (id ? *id : std::string());
+    for (size_t i = 0; i < svg->children.size(); ) {
+      const XMLElement* use = svg->children[i].get();
+      const std::string* useHref = use->GetAttribute(kXLinkHref);
+      if (use->tag == "use" && useHref && *useHref == href) {
+        svg->children.erase(svg->children.begin() + i);
+      } else {
+        ++i;
+      }
+    }
+    RemoveChild(svg, symbol);
+  }
+}
+
+bool ParseSVGForComparison(const std::string& svg,
+                      std::unique_ptr<XMLElement>* root, std::string* error) {
+  static const char kSVGNamespace[] = "xmlns=\"http://www.w3.org/2000/svg\"";
+  std::string text(svg);
+  size_t pos;
+  while ((pos = text.find(kSVGNamespace)) != std::string::npos) {
+    text.erase(pos, sizeof(kSVGNamespace) - 1);
+  }
+  return ParseXML(text, root, error);
+}
+
+}  // namespace fonttest
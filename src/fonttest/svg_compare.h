@@ -0,0 +1,74 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_SVG_COMPARE_H_
+#define FONTTEST_SVG_COMPARE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "fonttest/xml.h"
+
+namespace fonttest {
+
+// Describes where two SVG documents first differ.
+struct SVGDifference {
+  std::string location;  // "svg/symbol[1]/path@d", token 17
+  std::string expected;
+  std::string observed;
+};
+
+// Collapses whitespace in path data and drops symbols with empty paths,
+// together with the <use> elements that refer to them. Same as
+// ConformanceChecker.normalize_svg() in check.py.
+void NormalizeSVG(XMLElement* svg);
+
+// Appends |svg| to |out| in a canonical form: no whitespace between
+// elements, attributes sorted by name, and namespace prefixes declared
+// on the root. Documents that only differ in formatting have the same
+// canonical form once normalized by NormalizeSVG(), and documents with
+// the same canonical form are similar to each other.
+void WriteCanonicalSVG(const XMLElement& svg, std::string* out);
+
+// Parses |svg| like ParseSVGForComparison(), normalizes it and replaces
+// |canonical| by its canonical form.
+bool CanonicalizeSVG(const std::string& svg, std::string* canonical,
+                     std::string* error);
+
+// Returns a 64-bit hash of a canonical SVG document, so that callers can
+// recognize an unchanged rendering without comparing coordinates.
+uint64_t HashCanonicalSVG(const std::string& canonical);
+
+// Checks whether |observed| matches |expected|, allowing coordinates in
+// "d", "viewBox", "x" and "y" to differ by up to |maxDelta|. Same as
+// is_similar() in svgutil.py, including its treatment of attributes
+// that only |observed| has (they are ignored). If the documents are not
+// similar and |difference| is not NULL, it receives the first mismatch.
+bool IsSimilarSVG(const XMLElement& expected, const XMLElement& observed,
+                  double maxDelta, SVGDifference* difference);
+
+// Same as is_similar_path() in svgutil.py.
+bool IsSimilarPath(const std::string& expected, const std::string& observed,
+                   double maxDelta, SVGDifference* difference);
+
+// Parses an SVG document, such as the output of FontEngine::RenderSVG(),
+// the way check.py does it: the SVG default namespace is ignored, so that
+// tag names match those of the expected SVG embedded in the test cases.
+bool ParseSVGForComparison(const std::string& svg,
+                      std::unique_ptr<XMLElement>* root, std::string* error);
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_SVG_COMPARE_H_
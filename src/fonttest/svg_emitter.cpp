@@ -0,0 +1,141 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "fonttest/freestack_path.h"
+#include "fonttest/perf_counters.h"
+#include "fonttest/svg_emitter.h"
+#include "fonttest/svg_path_writer.h"
+#include "fonttest/trace.h"
+
+namespace fonttest {
+
+SVGEmitter::SVGEmitter() {
+}
+
+SVGEmitter::~SVGEmitter() {
+}
+
+void SVGEmitter::AppendGlyphName(FT_Face face, uint32_t glyphID,
+                                 std::string* out) {
+  char glyphName[512];
+  FT_Error error =
+      FT_Get_Glyph_Name(face, glyphID, glyphName, sizeof(glyphName));
+  if (error || *glyphName == '\0') {
+    out->append("gid");
+    AppendDecimal(static_cast<long>(glyphID), out);
+  } else {
+    out->append(glyphName);
+  }
+}
+
+void SVGEmitter::AppendSymbolID(const std::string& idPrefix,
+                                uint32_t glyphID, std::string* out) const {
+  const size_t index = glyphSlots_[glyphID] - 1;
+  const size_t start = index > 0 ? glyphNameEnds_[index - 1] : 0;
+  out->append(idPrefix);
+  out->append(".");
+  out->append(glyphNames_, start, glyphNameEnds_[index] - start);
+}
+
+bool SVGEmitter::Emit(const GlyphRun& run, FT_Face face, double fontSize,
+                      const std::string& idPrefix,
+                      OutlineCache* outlineCache,
+                      OutlineCache::Instance* instance,
+                      std::string* svg) {
+  TraceSpan span("SVGEmitter::Emit");
+  PerfScope perf(kPerfStageSerialize);
+  const double ascender = fontSize *
+      (static_cast<double>(face->ascender) /
+       static_cast<double>(face->units_per_EM));
+  const double descender = fontSize *
+      (static_cast<double>(face->descender) /
+       static_cast<double>(face->units_per_EM));
+
+  const size_t numGlyphs = run.GetSize();
+  int64_t width = 0;
+  for (size_t i = 0; i < numGlyphs; ++i) {
+    width += run.xAdvances[i];
+  }
+
+  svg->clear();
+  svg->append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<svg version=\"1.1\"\n"
+              "    xmlns=\"http://www.w3.org/2000/svg\"\n"
+              "    xmlns:xlink=\"http://www.w3.org/1999/xlink\"\n"
+              "    viewBox=\"0 ");
+  AppendDecimal(lround(descender), svg);
+  svg->push_back(' ');
+  AppendDecimal(lround(width * run.scale), svg);
+  svg->push_back(' ');
+  AppendDecimal(lround(ascender - descender), svg);
+  svg->append("\">\n");
+
+  const size_t numFaceGlyphs = static_cast<size_t>(face->num_glyphs);
+  if (glyphSlots_.size() < numFaceGlyphs) {
+    glyphSlots_.resize(numFaceGlyphs, 0);
+  }
+  uniqueGlyphs_.clear();
+  glyphNames_.clear();
+  glyphNameEnds_.clear();
+  bool ok = true;
+  for (size_t i = 0; ok && i < numGlyphs; ++i) {
+    const uint32_t glyphID = run.glyphIDs[i];
+    if (glyphID >= glyphSlots_.size()) {
+      glyphSlots_.resize(glyphID + 1, 0);
+    }
+    if (glyphSlots_[glyphID] != 0) {
+      continue;
+    }
+
+    AppendGlyphName(face, glyphID, &glyphNames_);
+    glyphNameEnds_.push_back(glyphNames_.size());
+    uniqueGlyphs_.push_back(glyphID);
+    glyphSlots_[glyphID] = static_cast<uint32_t>(uniqueGlyphs_.size());
+    svg->append("  <symbol id=\"");
+    AppendSymbolID(idPrefix, glyphID, svg);
+    svg->append("\" overflow=\"visible\"><path d=\"");
+    ok = AppendGlyphPath(face, glyphID, outlineCache, instance, svg);
+    svg->append("\"/></symbol>\n");
+  }
+
+  int64_t x = 0, y = 0;
+  for (size_t i = 0; ok && i < numGlyphs; ++i) {
+    svg->append("  <use xlink:href=\"#");
+    AppendSymbolID(idPrefix, run.glyphIDs[i], svg);
+    svg->append("\" x=\"");
+    AppendDecimal(lround((x + run.xOffsets[i]) * run.scale), svg);
+    svg->append("\" y=\"");
+    AppendDecimal(lround((y + run.yOffsets[i]) * run.scale), svg);
+    svg->append("\"/>\n");
+    x += run.xAdvances[i];
+    y += run.yAdvances[i];
+  }
+
+  svg->append("</svg>\n");
+
+  for (uint32_t glyphID : uniqueGlyphs_) {
+    glyphSlots_[glyphID] = 0;
+  }
+  return ok;
+}
+
+}  // namespace fonttest
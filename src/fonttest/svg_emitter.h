@@ -0,0 +1,67 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_SVG_EMITTER_H_
+#define FONTTEST_SVG_EMITTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "fonttest/glyph_run.h"
+#include "fonttest/outline_cache.h"
+
+namespace fonttest {
+
+// Serializes a GlyphRun into the SVG document format that the test
+// cases expect: one <symbol> per distinct glyph, followed by one <use>
+// per glyph. Shared by all FreeType-based engines. Keeps scratch state
+// between calls, so an engine should hold on to its emitter; once the
+// scratch buffers have grown, emitting a run does not allocate.
+class SVGEmitter {
+ public:
+  SVGEmitter();
+  ~SVGEmitter();
+
+  // |face| must already be set up for the size and variation at which
+  // |run| was shaped.
+  bool Emit(const GlyphRun& run, FT_Face face, double fontSize,
+            const std::string& idPrefix,
+            OutlineCache* outlineCache, OutlineCache::Instance* instance,
+            std::string* svg);
+
+ private:
+  void AppendGlyphName(FT_Face face, uint32_t glyphID, std::string* out);
+  void AppendSymbolID(const std::string& idPrefix, uint32_t glyphID,
+                      std::string* out) const;
+
+  // For every glyph ID, 1 + its index in uniqueGlyphs_, or 0 if the
+  // glyph has not occurred in the current run. Only the entries of
+  // uniqueGlyphs_ get reset after a run.
+  std::vector<uint32_t> glyphSlots_;
+  std::vector<uint32_t> uniqueGlyphs_;
+
+  // The names of uniqueGlyphs_, concatenated.
+  std::string glyphNames_;
+  std::vector<size_t> glyphNameEnds_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_SVG_EMITTER_H_
@@ -0,0 +1,93 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+
+#include "fonttest/svg_path_writer.h"
+
+namespace fonttest {
+
+void AppendDecimal(long value, std::string* out) {
+  char buffer[24];
+  char* end = buffer + sizeof(buffer);
+  char* p = end;
+  // Negate in unsigned arithmetic, so that LONG_MIN does not overflow.
+  unsigned long magnitude = static_cast<unsigned long>(value);
+  if (value < 0) {
+    magnitude = 0UL - magnitude;
+  }
+  do {
+    *--p = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    *--p = '-';
+  }
+  out->append(p, end - p);
+}
+
+SVGPathWriter::SVGPathWriter(std::string* out)
+  : out_(out), start_(out->size()) {
+}
+
+SVGPathWriter::~SVGPathWriter() {
+}
+
+void SVGPathWriter::MoveTo(long x, long y) {
+  AppendCommand('M');
+  AppendPoint(x, y);
+}
+
+void SVGPathWriter::LineTo(long x, long y) {
+  AppendCommand('L');
+  AppendPoint(x, y);
+}
+
+void SVGPathWriter::QuadTo(long controlX, long controlY, long x, long y) {
+  AppendCommand('Q');
+  AppendPoint(controlX, controlY);
+  out_->push_back(' ');
+  AppendPoint(x, y);
+}
+
+void SVGPathWriter::CurveTo(long control1X, long control1Y,
+                            long control2X, long control2Y,
+                            long x, long y) {
+  AppendCommand('C');
+  AppendPoint(control1X, control1Y);
+  out_->push_back(' ');
+  AppendPoint(control2X, control2Y);
+  out_->push_back(' ');
+  AppendPoint(x, y);
+}
+
+void SVGPathWriter::ClosePath() {
+  AppendCommand('Z');
+}
+
+void SVGPathWriter::AppendCommand(char command) {
+  if (!IsEmpty()) {
+    out_->push_back(' ');
+  }
+  out_->push_back(command);
+}
+
+void SVGPathWriter::AppendPoint(long x, long y) {
+  AppendDecimal(x, out_);
+  out_->push_back(',');
+  AppendDecimal(y, out_);
+}
+
+}  // namespace fonttest
@@ -0,0 +1,56 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_SVG_PATH_WRITER_H_
+#define FONTTEST_SVG_PATH_WRITER_H_
+
+#include <cstddef>
+#include <string>
+
+namespace fonttest {
+
+// Appends the decimal representation of |value| to |out|.
+void AppendDecimal(long value, std::string* out);
+
+// Writes SVG path data with integer coordinates, such as "M1,2 L3,4 Z".
+// Numbers are formatted by hand rather than with snprintf(), which is
+// locale-aware and far slower. Output is appended to a caller-provided
+// string; callers that reserve() and reuse it avoid any allocation.
+class SVGPathWriter {
+ public:
+  explicit SVGPathWriter(std::string* out);
+  ~SVGPathWriter();
+
+  // True if nothing has been written since construction.
+  bool IsEmpty() const { return out_->size() == start_; }
+
+  void MoveTo(long x, long y);
+  void LineTo(long x, long y);
+  void QuadTo(long controlX, long controlY, long x, long y);
+  void CurveTo(long control1X, long control1Y,
+               long control2X, long control2Y, long x, long y);
+  void ClosePath();
+
+ private:
+  void AppendCommand(char command);
+  void AppendPoint(long x, long y);
+
+  std::string* out_;
+  const size_t start_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_SVG_PATH_WRITER_H_
@@ -19,21 +19,38 @@
 extern "C" {
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 }
 
+#include "fonttest/font_cache.h"
 #include "fonttest/font_engine.h"
 #include "fonttest/freestack_font.h"
+#include "fonttest/freestack_path.h"
+#include "fonttest/perf_counters.h"
+#include "fonttest/sfnt_file.h"
 #include "fonttest/tehreerstack_line.h"
 #include "fonttest/tehreerstack_engine.h"
+#include "fonttest/trace.h"
+
+#ifndef FONTTEST_SHEENBIDI_VERSION
+#define FONTTEST_SHEENBIDI_VERSION "2.0"
+#endif
+
+#ifndef FONTTEST_SHEENFIGURE_VERSION
+#define FONTTEST_SHEENFIGURE_VERSION "1.5"
+#endif
 
 namespace fonttest {
 
 TehreerStackEngine::TehreerStackEngine() {
-  FT_Init_FreeType(&freeTypeLibrary_);
+  freeTypeMemory_.NewLibrary(&freeTypeLibrary_);
 }
 
 TehreerStackEngine::~TehreerStackEngine() {
-  FT_Done_FreeType(freeTypeLibrary_);
+  // Cached faces belong to our FreeType library, so they must be
+  // released before the library itself goes away.
+  GetFontCache()->Clear();
+  FT_Done_Library(freeTypeLibrary_);
 }
 
 std::string TehreerStackEngine::GetName() const {
@@ -47,15 +64,19 @@ std::string TehreerStackEngine::GetVersion() const {
   FT_Library_Version(freeTypeLibrary_, &ftMajor, &ftMinor, &ftPatch);
   result << "FreeType/" << ftMajor << '.' << ftMinor << '.' << ftPatch;
 
-  result << " SheenBidi/2.0";
+  // Neither library has a version macro; CMake describes their
+  // submodules, so that the version changes with every update.
+  result << " SheenBidi/" << FONTTEST_SHEENBIDI_VERSION;
 
-  result << " SheenFigure/1.5";
+  result << " SheenFigure/" << FONTTEST_SHEENFIGURE_VERSION;
 
   return result.str();
 }
 
 Font* TehreerStackEngine::LoadFont(
     const std::string& path, int faceIndex) {
+  TraceSpan span("TehreerStackEngine::LoadFont");
+  PerfScope perf(kPerfStageLoadFont);
   FT_Face face = NULL;
   FT_Error error = FT_New_Face(freeTypeLibrary_, path.c_str(),
 			       static_cast<FT_Long>(faceIndex), &face);
@@ -63,7 +84,9 @@ Font* TehreerStackEngine::LoadFont(
     return NULL;
   }
 
-  return new FreeStackFont(face);
+  // SheenFigure reads the layout tables straight from the mapped file.
+  return new FreeStackFont(face, &outlineCache_, &instanceCacheStats_,
+                           SfntFile::Open(path, faceIndex));
 }
 
 bool TehreerStackEngine::RenderSVG(const std::string& text,
@@ -72,9 +95,44 @@ bool TehreerStackEngine::RenderSVG(const std::string& text,
                                    const FontVariation& fontVariation,
                                    const std::string& idPrefix,
                                    std::string* svg) {
-  FT_Face face = static_cast<FreeStackFont*>(font)->GetFace(fontSize, fontVariation);
-  TehreerStackLine line(text, textLanguage, face, fontSize);
-  return line.RenderSVG(idPrefix, svg);
+  TraceSpan span("TehreerStackEngine::RenderSVG");
+  FreeStackFont* freeStackFont = static_cast<FreeStackFont*>(font);
+  FT_Face face = freeStackFont->GetFace(fontSize, fontVariation);
+  if (!face) {
+    return false;
+  }
+  TehreerStackLine line(text, textLanguage,
+                        freeStackFont->GetSheenFigureInstance(), fontSize);
+  if (!line.GetGlyphRun(&glyphRun_)) {
+    return false;
+  }
+  return svgEmitter_.Emit(glyphRun_, face, fontSize, idPrefix, &outlineCache_,
+                          outlineCache_.GetInstance(
+                              freeStackFont->GetInstanceKey()), svg);
+}
+
+bool TehreerStackEngine::RenderGlyphs(const std::string& text,
+                                      const std::string& textLanguage,
+                                      Font* font, double fontSize,
+                                      const FontVariation& fontVariation,
+                                      bool withOutlines, GlyphRun* run) {
+  TraceSpan span("TehreerStackEngine::RenderGlyphs");
+  FreeStackFont* freeStackFont = static_cast<FreeStackFont*>(font);
+  FT_Face face = freeStackFont->GetFace(fontSize, fontVariation);
+  if (!face) {
+    return false;
+  }
+  TehreerStackLine line(text, textLanguage,
+                        freeStackFont->GetSheenFigureInstance(), fontSize);
+  if (!line.GetGlyphRun(run)) {
+    return false;
+  }
+  if (withOutlines) {
+    return AddGlyphRunOutlines(face, &outlineCache_,
+                               outlineCache_.GetInstance(
+                                   freeStackFont->GetInstanceKey()), run);
+  }
+  return true;
 }
 
 }  // namespace fonttest
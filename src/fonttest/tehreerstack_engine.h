@@ -23,6 +23,11 @@
 #include FT_FREETYPE_H
 
 #include "fonttest/font.h"
+#include "fonttest/freetype_memory.h"
+#include "fonttest/glyph_run.h"
+#include "fonttest/instance_cache.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/svg_emitter.h"
 
 namespace fonttest {
 
@@ -33,6 +38,11 @@ class TehreerStackEngine : public FontEngine {
   virtual std::string GetName() const;
   virtual std::string GetVersion() const;
   virtual Font* LoadFont(const std::string& path, int faceIndex);
+  virtual OutlineCache* GetOutlineCache() { return &outlineCache_; }
+  virtual FreeTypeMemory* GetFreeTypeMemory() { return &freeTypeMemory_; }
+  virtual const InstanceCacheStats* GetInstanceCacheStats() const {
+    return &instanceCacheStats_;
+  }
 
   // Renders a line of text into an SVG document.
   virtual bool RenderSVG(const std::string& text,
@@ -42,8 +52,19 @@ class TehreerStackEngine : public FontEngine {
                          const std::string& idPrefix,
                          std::string* svg);
 
+  virtual bool RenderGlyphs(const std::string& text,
+                            const std::string& textLanguage,
+                            Font* font, double fontSize,
+                            const FontVariation& fontVariation,
+                            bool withOutlines, GlyphRun* run);
+
  private:
+  FreeTypeMemory freeTypeMemory_;
   FT_Library freeTypeLibrary_;
+  OutlineCache outlineCache_;
+  InstanceCacheStats instanceCacheStats_;
+  GlyphRun glyphRun_;
+  SVGEmitter svgEmitter_;
 };
 
 }  // namespace fonttest
@@ -13,10 +13,10 @@
  * limitations under the License.
  */
 
-#include <cmath>
 #include <cstddef>
-#include <cstdio>
-#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -31,125 +31,226 @@ extern "C" {
 #include <SheenFigure.h>
 }
 
-#include "fonttest/freestack_path.h"
+#include "fonttest/perf_counters.h"
 #include "fonttest/tehreerstack_line.h"
+#include "fonttest/trace.h"
 
 namespace fonttest {
 
-static SFFontRef DeriveVariableFont(FT_Face face, SFFontRef font) {
-  SFFontRef derivedFont = font;
-  FT_MM_Var *variation;
+namespace {
+
+// Buffers of the lines of one thread, kept from line to line. The
+// artist and album keep their own buffers between runs, too.
+struct LineScratch {
+  LineScratch()
+    : artist(SFArtistCreate()), album(SFAlbumCreate()),
+      glyphRunInUse(false) {}
+  ~LineScratch() {
+    SFAlbumRelease(album);
+    SFArtistRelease(artist);
+  }
 
-  if (FT_Get_MM_Var(face, &variation) == FT_Err_Ok) {
-    FT_UInt coordCount = variation->num_axis;
-    FT_Fixed fixedCoords[coordCount];
-    SFInt16 coordArray[coordCount];
+  SFArtistRef artist;
+  SFAlbumRef album;
+  std::vector<SBScript> scripts;
+  GlyphRun glyphRun;
+  bool glyphRunInUse;
+};
 
-    if (FT_Get_Var_Blend_Coordinates(face, coordCount, fixedCoords) == FT_Err_Ok) {
-      for (FT_UInt i = 0; i < coordCount; i++) {
-        coordArray[i] = static_cast<SFInt16>(fixedCoords[i] >> 2);
-      }
+thread_local LineScratch lineScratch;
 
-      derivedFont = SFFontCreateWithVariationCoordinates(font, face, coordArray, coordCount);
-      SFFontRelease(font);
+}  // namespace
+
+static void PopulateScriptArray(SBScript *scriptArr, const SBCodepointSequence *uniSeq) {
+  TraceSpan span("itemize");
+  SBScriptLocatorRef scriptLoc = SBScriptLocatorCreate();
+  const SBScriptAgent *scriptAgent = SBScriptLocatorGetAgent(scriptLoc);
+  SBScriptLocatorLoadCodepoints(scriptLoc, uniSeq);
+
+  while (SBScriptLocatorMoveNext(scriptLoc)) {
+    for (size_t i = 0; i < scriptAgent->length; i++) {
+      scriptArr[scriptAgent->offset + i] = scriptAgent->script;
     }
+  }
+
+  SBScriptLocatorRelease(scriptLoc);
+}
+
+// SheenFigure positions glyphs in font units, which GlyphRun keeps as they
+// are; the caller sets the scale from font units to pixels.
+static void AppendGlyphs(SFAlbumRef album, SFTextDirection direction, GlyphRun *run) {
+  SFUInteger len = SFAlbumGetGlyphCount(album);
+  const SFGlyphID *glyphIDs = SFAlbumGetGlyphIDsPtr(album);
+  const SFPoint *offsets = SFAlbumGetGlyphOffsetsPtr(album);
+  const SFInt32 *advances = SFAlbumGetGlyphAdvancesPtr(album);
+
+  SFBoolean rev = (direction == SFTextDirectionRightToLeft);
 
-    FT_Done_MM_Var(face->glyph->library, variation);
+  for (SFUInteger j = 0; j < len; j++) {
+    SFUInteger i = (rev ? len - 1 - j : j);
+    run->Append(glyphIDs[i], offsets[i].x, offsets[i].y, advances[i], 0);
   }
+}
+
+SheenFigureInstance::SheenFigureInstance(
+    FT_Face face, const std::shared_ptr<const SfntFile>& sfntFile)
+  : face_(face), sfntFile_(sfntFile), font_(CreateFont()),
+    scheme_(SFSchemeCreate()) {
+  SFSchemeSetFont(scheme_, font_);
+}
 
-  return derivedFont;
+SheenFigureInstance::~SheenFigureInstance() {
+  for (const Pattern& pattern : patterns_) {
+    SFPatternRelease(pattern.pattern);
+  }
+  SFSchemeRelease(scheme_);
+  SFFontRelease(font_);
 }
 
-static SFFontRef CreateFontInstance(FT_Face face) {
+SFFontRef SheenFigureInstance::CreateFont() {
+  TraceSpan span("SFFontCreateWithProtocol");
+  PerfScope perf(kPerfStageShaping);
   SFFontProtocol protocol;
   protocol.finalize = nullptr;
+  // SheenFigure asks for the length of a table first, and then for its
+  // contents in a buffer of its own.
   protocol.loadTable = [](void *object, SFTag tag, SFUInt8 *buffer, SFUInteger *length) {
-    FT_Face face = reinterpret_cast<FT_Face>(object);
+    SheenFigureInstance* instance = static_cast<SheenFigureInstance*>(object);
+    if (instance->sfntFile_) {
+      const uint8_t* data = nullptr;
+      size_t size = 0;
+      instance->sfntFile_->GetTable(tag, &data, &size);
+      if (buffer && size) {
+        memcpy(buffer, data, size);
+      }
+      if (length) {
+        *length = size;
+      }
+      return;
+    }
+
     FT_ULong size = 0;
-    FT_Load_Sfnt_Table(face, tag, 0, buffer, length ? &size : nullptr);
+    FT_Load_Sfnt_Table(instance->face_, tag, 0, buffer, length ? &size : nullptr);
 
     if (length) {
       *length = size;
     }
   };
   protocol.getGlyphIDForCodepoint = [](void *object, SFCodepoint codepoint) {
-    FT_Face face = reinterpret_cast<FT_Face>(object);
+    FT_Face face = static_cast<SheenFigureInstance*>(object)->face_;
     FT_UInt glyphID = FT_Get_Char_Index(face, codepoint);
 
     return static_cast<SFGlyphID>(glyphID);
   };
   protocol.getAdvanceForGlyph = [](void *object, SFFontLayout fontLayout, SFGlyphID glyphID) {
-    FT_Face face = reinterpret_cast<FT_Face>(object);
-    FT_Fixed advance = 0;
-    FT_Get_Advance(face, glyphID, FT_LOAD_NO_SCALE, &advance);
-
-    return static_cast<SFInt32>(advance);
+    return static_cast<SheenFigureInstance*>(object)->GetAdvance(glyphID);
   };
 
-  return DeriveVariableFont(face, SFFontCreateWithProtocol(&protocol, face));
-}
+  SFFontRef font = SFFontCreateWithProtocol(&protocol, this);
 
-static void PopulateScriptArray(SBScript *scriptArr, const SBCodepointSequence *uniSeq) {
-  SBScriptLocatorRef scriptLoc = SBScriptLocatorCreate();
-  const SBScriptAgent *scriptAgent = SBScriptLocatorGetAgent(scriptLoc);
-  SBScriptLocatorLoadCodepoints(scriptLoc, uniSeq);
+  // Derive the variable instance, which shares the tables of |font|.
+  FT_MM_Var *variation;
+  if (FT_Get_MM_Var(face_, &variation) == FT_Err_Ok) {
+    FT_UInt coordCount = variation->num_axis;
+    std::vector<FT_Fixed> fixedCoords(coordCount);
+    std::vector<SFInt16> coordArray(coordCount);
 
-  while (SBScriptLocatorMoveNext(scriptLoc)) {
-    for (size_t i = 0; i < scriptAgent->length; i++) {
-      scriptArr[scriptAgent->offset + i] = scriptAgent->script;
+    if (coordCount > 0 &&
+        FT_Get_Var_Blend_Coordinates(face_, coordCount, fixedCoords.data()) == FT_Err_Ok) {
+      for (FT_UInt i = 0; i < coordCount; i++) {
+        coordArray[i] = static_cast<SFInt16>(fixedCoords[i] >> 2);
+      }
+
+      SFFontRef derivedFont = SFFontCreateWithVariationCoordinates(
+          font, this, coordArray.data(), coordCount);
+      SFFontRelease(font);
+      font = derivedFont;
     }
+
+    FT_Done_MM_Var(face_->glyph->library, variation);
   }
 
-  SBScriptLocatorRelease(scriptLoc);
+  return font;
 }
 
-static void InsertGlyphInfos(SFAlbumRef album, SFTextDirection direction, double ppem, std::vector<GlyphInfo> &glyphInfos) {
-  SFUInteger len = SFAlbumGetGlyphCount(album);
-  const SFGlyphID *glyphIDs = SFAlbumGetGlyphIDsPtr(album);
-  const SFPoint *offsets = SFAlbumGetGlyphOffsetsPtr(album);
-  const SFInt32 *advances = SFAlbumGetGlyphAdvancesPtr(album);
+// Marks the advances that have not been looked up yet.
+static const SFInt32 kUnknownAdvance = INT32_MIN;
 
-  SFBoolean rev = (direction == SFTextDirectionRightToLeft);
-  SFUInteger inc = (rev ? -1 : 1);
+SFInt32 SheenFigureInstance::GetAdvance(SFGlyphID glyphID) {
+  if (glyphID >= face_->num_glyphs) {
+    return 0;
+  }
 
-  for (SFInteger i = (rev ? len - 1 : 0); i >= 0 && i < len; i += inc) {
-    GlyphInfo glyphInfo = {
-      glyphIDs[i],
-      offsets[i].x * ppem,
-      offsets[i].y * ppem,
-      advances[i] * ppem
-    };
+  if (advances_.empty()) {
+    advances_.assign(static_cast<size_t>(face_->num_glyphs), kUnknownAdvance);
+  }
+  SFInt32& advance = advances_[glyphID];
+  if (advance == kUnknownAdvance) {
+    FT_Fixed fixedAdvance = 0;
+    FT_Get_Advance(face_, glyphID, FT_LOAD_NO_SCALE, &fixedAdvance);
+    advance = static_cast<SFInt32>(fixedAdvance);
+  }
+  return advance;
+}
 
-    glyphInfos.push_back(glyphInfo);
+SFPatternRef SheenFigureInstance::GetPattern(SFTag scriptTag,
+                                             SFTag languageTag) {
+  for (const Pattern& pattern : patterns_) {
+    if (pattern.scriptTag == scriptTag &&
+        pattern.languageTag == languageTag) {
+      return pattern.pattern;
+    }
   }
+
+  TraceSpan span("SFSchemeBuildPattern");
+  SFSchemeSetScriptTag(scheme_, scriptTag);
+  SFSchemeSetLanguageTag(scheme_, languageTag);
+  Pattern pattern;
+  pattern.scriptTag = scriptTag;
+  pattern.languageTag = languageTag;
+  pattern.pattern = SFSchemeBuildPattern(scheme_);
+  patterns_.push_back(pattern);
+  return pattern.pattern;
 }
 
 TehreerStackLine::TehreerStackLine(
     const std::string& text, const std::string& textLanguage,
-    FT_Face font, double fontSize)
-  : font_(font), fontSize_(fontSize) {
-  sfFont_ = CreateFontInstance(font);
-
-  const double ppem = fontSize / font->units_per_EM;
+    SheenFigureInstance* instance, double fontSize)
+  : glyphRun_(&ownGlyphRun_) {
+  TraceSpan span("TehreerStackLine");
+  PerfScope perf(kPerfStageShaping);
+  if (!lineScratch.glyphRunInUse) {
+    lineScratch.glyphRunInUse = true;
+    glyphRun_ = &lineScratch.glyphRun;
+    glyphRun_->Clear();
+  }
+  glyphRun_->scale = fontSize / instance->GetFace()->units_per_EM;
 
   const char *txtBuf = text.c_str();
   SBUInteger txtLen = text.length();
   SBCodepointSequence uniSeq = { SBStringEncodingUTF8, (void *)txtBuf, txtLen };
 
-  SBScript *scriptArr = new SBScript[text.length()];
+  std::vector<SBScript>& scripts = lineScratch.scripts;
+  scripts.resize(text.length());
+  SBScript *scriptArr = scripts.data();
   PopulateScriptArray(scriptArr, &uniSeq);
 
-  SFArtistRef artist = SFArtistCreate();
-  SFSchemeRef scheme = SFSchemeCreate();
+  SFArtistRef artist = lineScratch.artist;
+  SFAlbumRef album = lineScratch.album;
 
   SBAlgorithmRef bidiAlgo = SBAlgorithmCreate(&uniSeq);
   SBUInteger paraStart = 0;
 
   while (paraStart != txtLen) {
-    SBParagraphRef paragraph = SBAlgorithmCreateParagraph(bidiAlgo, paraStart, txtLen, SBLevelDefaultLTR);
-    SBUInteger paraLen = SBParagraphGetLength(paragraph);
-
-    SBLineRef line = SBParagraphCreateLine(paragraph, 0, paraLen);
+    SBParagraphRef paragraph;
+    SBUInteger paraLen;
+    SBLineRef line;
+    {
+      TraceSpan span("bidi");
+      paragraph = SBAlgorithmCreateParagraph(bidiAlgo, paraStart, txtLen, SBLevelDefaultLTR);
+      paraLen = SBParagraphGetLength(paragraph);
+      line = SBParagraphCreateLine(paragraph, 0, paraLen);
+    }
     const SBRun *runArr = SBLineGetRunsPtr(line);
     SBUInteger runCount = SBLineGetRunCount(line);
 
@@ -181,23 +282,18 @@ TehreerStackLine::TehreerStackLine(
           textMode = SFTextModeBackward;
         }
 
-        SFSchemeSetFont(scheme, sfFont_);
-        SFSchemeSetScriptTag(scheme, scriptTag);
-        SFSchemeSetLanguageTag(scheme, SFTagMake('d', 'f', 'l', 't'));
-
-        SFPatternRef pattern = SFSchemeBuildPattern(scheme);
-        SFAlbumRef album = SFAlbumCreate();
-
-        SFArtistSetPattern(artist, pattern);
-        SFArtistSetString(artist, SFStringEncodingUTF8, shapeBuf, shapeLen);
-        SFArtistSetTextDirection(artist, scriptDir);
-        SFArtistSetTextMode(artist, textMode);
-        SFArtistFillAlbum(artist, album);
-
-        InsertGlyphInfos(album, scriptDir, ppem, glyphInfos);
+        SFPatternRef pattern = instance->GetPattern(
+            scriptTag, SFTagMake('d', 'f', 'l', 't'));
+        {
+          TraceSpan span("shape");
+          SFArtistSetPattern(artist, pattern);
+          SFArtistSetString(artist, SFStringEncodingUTF8, shapeBuf, shapeLen);
+          SFArtistSetTextDirection(artist, scriptDir);
+          SFArtistSetTextMode(artist, textMode);
+          SFArtistFillAlbum(artist, album);
+        }
 
-        SFAlbumRelease(album);
-        SFPatternRelease(pattern);
+        AppendGlyphs(album, scriptDir, glyphRun_);
       }
     }
 
@@ -207,107 +303,17 @@ TehreerStackLine::TehreerStackLine(
     paraStart += paraLen;
   }
 
-  SFSchemeRelease(scheme);
-  SFArtistRelease(artist);
-
-  delete [] scriptArr;
+  SBAlgorithmRelease(bidiAlgo);
 }
 
 TehreerStackLine::~TehreerStackLine() {
-  SFFontRelease(sfFont_);
-}
-
-bool TehreerStackLine::RenderSVG(const std::string& idPrefix, std::string* svg) {
-  svg->clear();
-
-  const double ascender = fontSize_ *
-      (static_cast<double>(font_->ascender) /
-       static_cast<double>(font_->units_per_EM));
-  const double descender = fontSize_ *
-      (static_cast<double>(font_->descender) /
-       static_cast<double>(font_->units_per_EM));
-
-  size_t len = glyphInfos.size();
-
-  std::string symbols;
-  std::map<int, std::string> glyphNames;
-  for (size_t i = 0; i < len; ++i) {
-    const GlyphInfo &glyph = glyphInfos[i];
-    if (glyphNames.find(glyph.glyphID) != glyphNames.end()) {
-      continue;
-    }
-
-    char glyphName[512];
-    FT_Error error = FT_Get_Glyph_Name(font_, glyph.glyphID, glyphName, sizeof(glyphName));
-    if (error || *glyphName == '\0') {
-      snprintf(glyphName, sizeof(glyphName), "gid%u", glyph.glyphID);
-    }
-    glyphNames[glyph.glyphID] = std::string(glyphName);
-
-    error = FT_Load_Glyph(font_, glyph.glyphID, FT_LOAD_NO_HINTING|FT_LOAD_NO_BITMAP);
-    if (error) {
-      std::cerr << "FT_Load_Glyph() failed; error: " << error << std::endl;
-      exit(1);
-    }
-
-    if (!font_->glyph) {
-      std::cerr << "FT_Load_Glyph() did not load a glyph" << std::endl;
-      exit(1);
-    }
-
-    symbols.append("  <symbol id=\"");
-    symbols.append(idPrefix);
-    symbols.append(".");
-    symbols.append(glyphName);
-    symbols.append("\" overflow=\"visible\"><path d=\"");
-    FT_Vector transform;
-    transform.x = transform.y = 0;
-    FreeTypePathConverter converter(transform);
-    symbols.append(converter.Convert(&font_->glyph->outline));
-    symbols.append("\"/></symbol>\n");
-  }
-
-  std::string uses;
-  double penX = 0;
-  for (size_t i = 0; i < len; i++) {
-    const GlyphInfo &glyph = glyphInfos[i];
-    const double glyphX = penX + glyph.xOffset;
-    const double glyphY = glyph.yOffset;
-    char buffer[1024];
-    snprintf(buffer, sizeof(buffer),
-             "  <use xlink:href=\"#%s.%s\" x=\"%ld\" y=\"%ld\"/>\n",
-             idPrefix.c_str(), glyphNames[glyph.glyphID].c_str(),
-             lround(glyphX), lround(glyphY));
-    uses.append(buffer);
-    penX += glyph.advance;
-  }
-
-  svg->clear();
-  svg->append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-              "<svg version=\"1.1\"\n"
-              "    xmlns=\"http://www.w3.org/2000/svg\"\n"
-              "    xmlns:xlink=\"http://www.w3.org/1999/xlink\"\n"
-              "    viewBox=\"");
-  char viewBox[200];
-  snprintf(viewBox, sizeof(viewBox), "%ld %ld %ld %ld",
-           0L, lround(descender), lround(penX),
-           lround(ascender - descender));
-  svg->append(viewBox);
-  svg->append("\">\n");
-
-  if (false) {
-    char buffer[200];
-    snprintf(buffer, sizeof(buffer),
-	     "  <rect fill=\"none\" stroke=\"blue\" stroke-width=\"10\" "
-	     "x=\"%ld\" y=\"%ld\" width=\"%ld\" height=\"%ld\"/>\n",
-	     0L, lround(descender), lround(penX),
-	     lround(ascender - descender));
-    svg->append(buffer);
+  if (glyphRun_ != &ownGlyphRun_) {
+    lineScratch.glyphRunInUse = false;
   }
+}
 
-  svg->append(symbols);
-  svg->append(uses);
-  svg->append("</svg>\n");
+bool TehreerStackLine::GetGlyphRun(GlyphRun* run) const {
+  *run = *glyphRun_;
   return true;
 }
 
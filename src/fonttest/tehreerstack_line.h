@@ -17,6 +17,7 @@
 #define FONTTEST_TEHREERSTACK_LINE_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,29 +29,79 @@ extern "C" {
 }
 
 #include "fonttest/font.h"
-
-struct GlyphInfo {
-    uint16_t glyphID;
-    double xOffset;
-    double yOffset;
-    double advance;
-};
+#include "fonttest/glyph_run.h"
+#include "fonttest/sfnt_file.h"
 
 namespace fonttest {
 
+// SheenFigure objects for one instance of a FreeStackFont, kept from
+// line to line: the SFFont, which reads tables and metrics from the face,
+// and the patterns built for it. Building a pattern walks the lookup
+// lists of GSUB and GPOS, which used to happen for every script run.
+class SheenFigureInstance {
+ public:
+  // |face| must be set up for the variation coordinates of the instance,
+  // both now and whenever the instance is used for shaping. SheenFigure
+  // works in font units, so the size of the face does not matter. If
+  // |sfntFile| is not NULL, tables are copied straight from its mapping
+  // instead of being read through FreeType.
+  SheenFigureInstance(FT_Face face,
+                      const std::shared_ptr<const SfntFile>& sfntFile);
+  ~SheenFigureInstance();
+
+  FT_Face GetFace() const { return face_; }
+  SFFontRef GetFont() const { return font_; }
+
+  // Returns the pattern for shaping runs in a script and language,
+  // building it on first use. The instance keeps the reference.
+  SFPatternRef GetPattern(SFTag scriptTag, SFTag languageTag);
+
+ private:
+  SheenFigureInstance(const SheenFigureInstance&);
+  void operator=(const SheenFigureInstance&);
+
+  SFFontRef CreateFont();
+  SFInt32 GetAdvance(SFGlyphID glyphID);
+
+  struct Pattern {
+    SFTag scriptTag;
+    SFTag languageTag;
+    SFPatternRef pattern;
+  };
+
+  FT_Face face_;
+  std::shared_ptr<const SfntFile> sfntFile_;
+
+  // Advances in font units by glyph ID, filled in as SheenFigure asks
+  // for them. For variable fonts, every FT_Get_Advance() call applies
+  // HVAR or gvar again; the table is per instance, and thus per set of
+  // variation coordinates.
+  std::vector<SFInt32> advances_;
+
+  SFFontRef font_;
+  SFSchemeRef scheme_;
+  std::vector<Pattern> patterns_;
+};
+
 class TehreerStackLine {
  public:
   TehreerStackLine(const std::string& text, const std::string& textLanguage,
-                   FT_Face font, double fontSize);
+                   SheenFigureInstance* instance, double fontSize);
   ~TehreerStackLine();
-  bool RenderSVG(const std::string& idPrefix, std::string* svg);
+
+  // Replaces the contents of |run| by the shaped glyphs of this line.
+  // Returns false, with |run| empty, if the line could not be shaped.
+  bool GetGlyphRun(GlyphRun* run) const;
 
  private:
-  SFFontRef sfFont_;
-  FT_Face font_;
-  double fontSize_;
+  TehreerStackLine(const TehreerStackLine&);
+  void operator=(const TehreerStackLine&);
 
-  std::vector<GlyphInfo> glyphInfos;
+  // Points to a glyph run that the thread's lines share, so that shaping
+  // reuses its capacity; or to ownGlyphRun_, if another line on the same
+  // thread is still holding the shared one.
+  GlyphRun* glyphRun_;
+  GlyphRun ownGlyphRun_;
 };
 
 }  // namespace fonttest
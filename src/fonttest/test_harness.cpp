@@ -14,53 +14,138 @@
  */
 
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "fonttest/batch_runner.h"
+#include "fonttest/disk_cache.h"
 #include "fonttest/font.h"
+#include "fonttest/font_cache.h"
 #include "fonttest/font_engine.h"
+#include "fonttest/freetype_memory.h"
+#include "fonttest/glyph_run.h"
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/instance_cache.h"
+#include "fonttest/outline_cache.h"
+#include "fonttest/parallel_runner.h"
+#include "fonttest/perf_counters.h"
+#include "fonttest/render_server.h"
+#include "fonttest/renderer.h"
+#include "fonttest/suite_runner.h"
+#include "fonttest/svg_compare.h"
 #include "fonttest/test_harness.h"
+#include "fonttest/trace.h"
+#include "fonttest/xml.h"
+#include "fonttest/zygote_runner.h"
 
 namespace fonttest {
 
-// Helper methods for parsing command-line arguments.
-static void TrimWhitespace(std::string* str);
-static void SplitString(const std::string& text, char sep,
-                        std::vector<std::string>* result);
+const double TestHarness::kMaxDelta = 1.0;
 
-static void ParseVariationSpec(const std::string& spec,
-                               FontVariation* variation) {
-  if (spec.empty()) {
-    return;
+TestHarness::TestHarness(const std::vector<std::string>& options)
+  : options_(options),
+    engine_(FontEngine::Create(GetOption("--engine="))) {
+  if (!engine_.get()) {
+    PrintUsageAndExit();
   }
+}
 
-  std::vector<std::string> v;
-  SplitString(spec, ';', &v);
-  for (const std::string& item : v) {
-    std::vector<std::string> keyValue;
-    SplitString(item, ':', &keyValue);
-    if (keyValue.size() != 2) {
-      std::cerr << "malformed --variation=" << spec << std::endl;
-      exit(1);
-    }
-    std::string key = keyValue[0];
-    std::string value = keyValue[1];
-    TrimWhitespace(&key);
-    TrimWhitespace(&value);
-    (*variation)[key] = std::atof(value.c_str());
+TestHarness::~TestHarness() {
+}
+
+int TestHarness::Run() {
+  const std::string tracePath = GetOption("--trace=");
+  if (!tracePath.empty() &&
+      (HasOption("--zygote=") || HasOption("--serve="))) {
+    // Zygote children exit without writing their spans, and the server
+    // never returns to write them, so its span buffers would only grow.
+    std::cerr << "--trace cannot be combined with --zygote or --serve"
+              << std::endl;
+    return 1;
+  }
+  if (!tracePath.empty()) {
+    Tracer::Start();
+  }
+  const bool perfCounters = HasOption("--perf-counters");
+  std::string error;
+  if (perfCounters && (HasOption("--zygote=") || HasOption("--serve="))) {
+    // Children render and exit without reporting their counts, so the
+    // table would only show what the parent did; the server never
+    // returns to print it at all.
+    std::cerr << "--perf-counters cannot be combined with --zygote or --serve"
+              << std::endl;
+    return 1;
+  }
+  if (perfCounters && !PerfCounters::Start(&error)) {
+    std::cerr << "--perf-counters: " << error << std::endl;
+    return 1;
+  }
+
+  int status;
+  {
+    TraceSpan span("TestHarness::Run");
+    status = RunMode();
   }
+
+  if (perfCounters) {
+    PerfCounters::Report(&std::cerr);
+  }
+  if (!tracePath.empty() && !Tracer::WriteJSON(tracePath, &error)) {
+    std::cerr << "failed to write trace: " << error << std::endl;
+    return 1;
+  }
+  return status;
 }
 
-TestHarness::TestHarness(const std::vector<std::string>& options)
-  : options_(options),
-    engine_(FontEngine::Create(GetOption("--engine="))) {
-  if (!engine_.get()) {
+int TestHarness::RunMode() {
+  if (HasOption("--version")) {
+    std::cout << engine_->GetVersion() << std::endl;
+    return 0;
+  }
+
+  OutputFormat format;
+  if (!ParseOutputFormat(GetOption("--format="), &format)) {
     PrintUsageAndExit();
   }
 
+  if (HasOption("--batch=")) {
+    RunBatch(GetOption("--batch="), format);
+    return 0;
+  }
+
+  if (HasOption("--serve=")) {
+    RunServer(GetOption("--serve="));
+    return 0;
+  }
+
+  if (HasOption("--zygote=")) {
+    RunZygote(GetOption("--zygote="), format);
+    return 0;
+  }
+
+  if (HasOption("--suite=")) {
+    return RunSuite(GetOption("--suite=")) ? 0 : 1;
+  }
+
+  FontVariation fontVariation;
+  const std::string testcase = GetOption("--testcase=");
+  TraceTestcase traceTestcase(testcase);
+  PerfTestcase perfTestcase(testcase);
+
+  FreeTypeMemory* memory =
+      HasOption("--memstats") ? engine_->GetFreeTypeMemory() : NULL;
+  FreeTypeMemory::Stats beforeLoad, beforeRender;
+  if (memory) {
+    beforeLoad = memory->GetStats();
+  }
+
+  // Loaded here rather than in the constructor, so that loading
+  // is traced and counted as part of the testcase.
   std::string fontPath = GetOption("--font=");
   int fontIndex = 0;
   if (!fontPath.empty()) {
@@ -70,28 +155,258 @@ TestHarness::TestHarness(const std::vector<std::string>& options)
       exit(1);
     }
   }
-}
-
-TestHarness::~TestHarness() {
-}
-
-void TestHarness::Run() {
-  if (HasOption("--version")) {
-    std::cout << engine_->GetVersion() << std::endl;
-    return;
-  }
 
-  FontVariation fontVariation;
-  const std::string testcase = GetOption("--testcase=");
   const std::string variationSpec = GetOption("--variation=");
-  ParseVariationSpec(variationSpec, &fontVariation);
+  if (!ParseVariationSpec(variationSpec, &fontVariation)) {
+    std::cerr << "malformed --variation=" << variationSpec << std::endl;
+    exit(1);
+  }
   const std::string text = GetOption("--render=");
   const std::string textLanguage = GetOption("--textLanguage=");
-  const double fontSize = 1000.0;
+  if (memory) {
+    memory->ResetRecentPeak();
+    beforeRender = memory->GetStats();
+  }
+  if (format != kFormatSVG) {
+    GlyphRun run;
+    if (!engine_->RenderGlyphs(text, textLanguage, font_.get(),
+                               Renderer::kFontSize, fontVariation,
+                               HasOption("--outlines"), &run)) {
+      std::cerr << "rendering failed, or " << engine_->GetName()
+                << " does not support --format=" << GetOption("--format=")
+                << std::endl;
+      exit(1);
+    }
+    if (memory) {
+      PrintFreeTypeMemoryUsage(testcase, beforeLoad, beforeRender,
+                               memory->GetStats(), &std::cerr);
+    }
+    std::string output;
+    if (format == kFormatGlyphsJSON) {
+      AppendGlyphRunJSON(testcase, run, &output);
+      output.push_back('\n');
+    } else {
+      AppendGlyphRunBinary(testcase, run, &output);
+    }
+    std::cout << output;
+    return 0;
+  }
+
   std::string svg;
-  engine_->RenderSVG(text, textLanguage, font_.get(), fontSize, fontVariation,
-                     testcase, &svg);
+  if (!engine_->RenderSVG(text, textLanguage, font_.get(), Renderer::kFontSize,
+                          fontVariation, testcase, &svg)) {
+    std::cerr << "rendering failed" << std::endl;
+    exit(1);
+  }
+  if (memory) {
+    PrintFreeTypeMemoryUsage(testcase, beforeLoad, beforeRender,
+                             memory->GetStats(), &std::cerr);
+  }
+  if (HasOption("--expected=")) {
+    return CompareWithExpected(testcase, svg) ? 0 : 1;
+  }
+  if (HasOption("--canonical")) {
+    std::string canonical, error;
+    if (!CanonicalizeSVG(svg, &canonical, &error)) {
+      std::cerr << "malformed SVG output: " << error << std::endl;
+      exit(1);
+    }
+    svg.swap(canonical);
+  }
   std::cout << svg;
+  return 0;
+}
+
+bool TestHarness::CompareWithExpected(const std::string& testcase,
+                                      const std::string& svg) {
+  const std::string path = GetOption("--expected=");
+  std::ifstream input(path.c_str());
+  if (!input) {
+    std::cerr << "failed to open expected SVG: " << path << std::endl;
+    exit(1);
+  }
+  std::stringstream expectedText;
+  expectedText << input.rdbuf();
+
+  std::unique_ptr<XMLElement> expected, observed;
+  std::string error;
+  if (!ParseSVGForComparison(expectedText.str(), &expected, &error)) {
+    std::cerr << path << ": " << error << std::endl;
+    exit(1);
+  }
+  if (!ParseSVGForComparison(svg, &observed, &error)) {
+    std::cerr << "malformed SVG output: " << error << std::endl;
+    exit(1);
+  }
+
+  NormalizeSVG(expected.get());
+  NormalizeSVG(observed.get());
+  SVGDifference difference;
+  if (IsSimilarSVG(*expected, *observed, kMaxDelta, &difference)) {
+    std::cout << "PASS " << testcase << std::endl;
+    return true;
+  }
+  std::cout << "FAIL " << testcase << std::endl
+            << "  at:       " << difference.location << std::endl
+            << "  expected: " << difference.expected << std::endl
+            << "  observed: " << difference.observed << std::endl;
+  return false;
+}
+
+void TestHarness::RunBatch(const std::string& manifest,
+                           OutputFormat format) {
+  BatchRunner runner(engine_->GetName(),
+                     std::atoi(GetOption("--jobs=").c_str()));
+  if (!runner.IsValid() || format == kFormatGlyphsBinary) {
+    PrintUsageAndExit();
+  }
+  runner.SetOutputFormat(format, HasOption("--outlines"));
+  ConfigureRunner(runner.GetParallelRunner());
+
+  if (manifest == "-") {
+    runner.Run(&std::cin, &std::cout);
+  } else {
+    std::ifstream input(manifest.c_str());
+    if (!input) {
+      std::cerr << "failed to open batch manifest: " << manifest << std::endl;
+      exit(1);
+    }
+    runner.Run(&input, &std::cout);
+  }
+
+  if (HasOption("--stats")) {
+    PrintStats(*runner.GetParallelRunner());
+  }
+}
+
+bool TestHarness::RunSuite(const std::string& suiteDir) {
+  SuiteRunner runner(engine_->GetName(),
+                     std::atoi(GetOption("--jobs=").c_str()));
+  if (!runner.IsValid()) {
+    PrintUsageAndExit();
+  }
+  ConfigureRunner(runner.GetParallelRunner());
+
+  std::string fontDir = GetOption("--fonts=");
+  if (fontDir.empty()) {
+    fontDir = "fonts";
+  }
+  const bool ok = runner.Run(suiteDir, fontDir, &std::cout);
+  if (HasOption("--stats")) {
+    PrintStats(*runner.GetParallelRunner());
+  }
+  return ok;
+}
+
+void TestHarness::RunZygote(const std::string& manifest,
+                            OutputFormat format) {
+  if (format == kFormatGlyphsBinary) {
+    PrintUsageAndExit();
+  }
+  double timeoutSeconds = 3.0;
+  if (HasOption("--timeout=")) {
+    timeoutSeconds = std::atof(GetOption("--timeout=").c_str());
+  }
+  if (HasOption("--font-cache-size=")) {
+    engine_->GetFontCache()->SetCapacity(
+        std::atoi(GetOption("--font-cache-size=").c_str()));
+  }
+
+  ZygoteRunner runner(engine_.get(), std::atoi(GetOption("--jobs=").c_str()),
+                      timeoutSeconds);
+  runner.SetOutputFormat(format, HasOption("--outlines"));
+  runner.SetCanonicalSVG(HasOption("--canonical"));
+  std::unique_ptr<DiskCache> diskCache;
+  if (HasOption("--disk-cache=")) {
+    diskCache.reset(new DiskCache(GetOption("--disk-cache=")));
+    runner.SetDiskCache(diskCache.get());
+  }
+  if (manifest == "-") {
+    runner.Run(&std::cin, &std::cout);
+  } else {
+    std::ifstream input(manifest.c_str());
+    if (!input) {
+      std::cerr << "failed to open batch manifest: " << manifest << std::endl;
+      exit(1);
+    }
+    runner.Run(&input, &std::cout);
+  }
+}
+
+void TestHarness::RunServer(const std::string& socketPath) {
+  RenderServer server(engine_->GetName(),
+                      std::atoi(GetOption("--jobs=").c_str()));
+  if (HasOption("--font-cache-size=")) {
+    server.SetFontCacheCapacity(
+        std::atoi(GetOption("--font-cache-size=").c_str()));
+  }
+  if (HasOption("--outline-cache-mb=")) {
+    const size_t megabytes = static_cast<size_t>(
+        std::atoi(GetOption("--outline-cache-mb=").c_str()));
+    server.SetOutlineCacheMaxBytes(megabytes * 1024 * 1024);
+  }
+
+  std::string error;
+  if (!server.Listen(socketPath, &error)) {
+    std::cerr << error << std::endl;
+    exit(1);
+  }
+  std::cerr << "listening on " << socketPath << std::endl;
+  server.Run();
+}
+
+void TestHarness::ConfigureRunner(ParallelRunner* runner) {
+  if (HasOption("--font-cache-size=")) {
+    runner->SetFontCacheCapacity(
+        std::atoi(GetOption("--font-cache-size=").c_str()));
+  }
+  if (HasOption("--outline-cache-mb=")) {
+    const size_t megabytes = static_cast<size_t>(
+        std::atoi(GetOption("--outline-cache-mb=").c_str()));
+    runner->SetOutlineCacheMaxBytes(megabytes * 1024 * 1024);
+  }
+  if (HasOption("--memstats")) {
+    runner->SetMemoryStatsOutput(&std::cerr);
+  }
+  if (HasOption("--canonical")) {
+    runner->SetCanonicalSVG(true);
+  }
+  if (HasOption("--disk-cache=")) {
+    runner->SetDiskCacheDirectory(GetOption("--disk-cache="));
+  }
+}
+
+void TestHarness::PrintStats(const ParallelRunner& runner) {
+  const FontCache::Stats stats = runner.GetFontCacheStats();
+  std::cerr << runner.GetNumThreads() << " threads; "
+            << "font cache: " << stats.hits << " hits, "
+            << stats.misses << " misses, "
+            << stats.evictions << " evictions" << std::endl;
+  const OutlineCache::Stats outlineStats = runner.GetOutlineCacheStats();
+  std::cerr << "outline cache: " << outlineStats.hits << " hits, "
+            << outlineStats.misses << " misses, "
+            << outlineStats.evictions << " evictions, "
+            << outlineStats.entries << " outlines in "
+            << outlineStats.bytes << " bytes" << std::endl;
+  const InstanceCacheStats instanceStats = runner.GetInstanceCacheStats();
+  if (instanceStats.hits + instanceStats.misses > 0) {
+    std::cerr << "instance cache: " << instanceStats.hits << " hits, "
+              << instanceStats.misses << " misses, "
+              << instanceStats.evictions << " evictions" << std::endl;
+  }
+  const DiskCache::Stats diskStats = runner.GetDiskCacheStats();
+  if (diskStats.hits + diskStats.misses > 0) {
+    std::cerr << "disk cache: " << diskStats.hits << " hits, "
+              << diskStats.misses << " misses, "
+              << diskStats.stores << " stores" << std::endl;
+  }
+  const FreeTypeMemory::Stats memoryStats = runner.GetFreeTypeMemoryStats();
+  if (memoryStats.allocations > 0) {
+    std::cerr << "FreeType memory: " << memoryStats.bytes << " bytes in use, "
+              << memoryStats.peakBytes << " bytes peak, "
+              << memoryStats.allocations << " allocations, "
+              << memoryStats.frees << " frees" << std::endl;
+  }
 }
 
 bool TestHarness::HasOption(const std::string& flag) const {
@@ -118,34 +433,37 @@ void TestHarness::PrintUsageAndExit() {
     << "  --render=Text" << std::endl
     << "  --variation=WGHT:700;WDTH:120" << std::endl
     << "  --testcase=AVAR-1/789" << std::endl
-    << "  --engine={FreeStack, TehreerStack, DirectWrite, CoreText}" << std::endl
-    << "  --font=path/to/testfont.otf" << std::endl;
+    << "  --engine={FreeStack, FreeStackHB, TehreerStack, DirectWrite, "
+    << "CoreText}" << std::endl
+    << "  --font=path/to/testfont.otf" << std::endl
+    << "  --format={svg, glyphs, glyphs-binary}" << std::endl
+    << "  --outlines (with --format=glyphs*)" << std::endl
+    << "  --expected=path/to/expected.svg" << std::endl
+    << "  --canonical (normalized SVG; with --batch or --zygote, a hash)"
+    << std::endl
+    << "  --batch=path/to/manifest.jsonl (or - for stdin)" << std::endl
+    << "  --zygote=path/to/manifest.jsonl (like --batch, one fork per test)"
+    << std::endl
+    << "  --timeout=3 (seconds per test, with --zygote)" << std::endl
+    << "  --serve=path/to/socket (render requests from clients)"
+    << std::endl
+    << "  --suite=path/to/testcases" << std::endl
+    << "  --fonts=path/to/fonts (with --suite; default: fonts)" << std::endl
+    << "  --jobs=0 (parallel workers; 0 for one per core)"
+    << std::endl
+    << "  --font-cache-size=32" << std::endl
+    << "  --outline-cache-mb=64" << std::endl
+    << "  --disk-cache=path/to/dir (with --batch, --suite or --zygote)"
+    << std::endl
+    << "  --stats" << std::endl
+    << "  --memstats (FreeType memory per font load and rendering)"
+    << std::endl
+    << "  --trace=path/to/trace.json (not with --zygote or --serve)"
+    << std::endl
+    << "  --perf-counters (Linux only, not with --zygote or --serve)"
+    << std::endl;
   exit(1);
 }
 
-void SplitString(const std::string& text, char sep,
-                 std::vector<std::string>* result) {
-  std::size_t start = 0, limit = 0;
-  while ((limit = text.find(sep, start)) != std::string::npos) {
-    result->push_back(text.substr(start, limit - start));
-    start = limit + 1;
-  }
-  result->push_back(text.substr(start));
-}
-
-void TrimWhitespace(std::string* str) {
-  static const char* whitespace = " \t\f\v\n\r";
-  const std::size_t start = str->find_first_not_of(whitespace);
-  if (start == std::string::npos) {
-    str->clear();
-    return;
-  }
-  str->substr(start).swap(*str);
-  const std::size_t end = str->find_last_not_of(whitespace);
-  if (end != std::string::npos) {
-    str->erase(end + 1);
-  }
-}
-
 }  // namespace fonttest
 
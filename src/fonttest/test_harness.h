@@ -21,20 +21,43 @@
 #include <string>
 #include <vector>
 
+#include "fonttest/glyph_run_format.h"
+
 namespace fonttest {
 
 class Font;
 class FontEngine;
+class ParallelRunner;
 
 typedef std::map<std::string, double> FontVariation;  // WGHT -> 400.0
 
 class TestHarness {
  public:
+  // Tolerance for coordinates in --expected= comparisons, like check.py.
+  static const double kMaxDelta;
+
   TestHarness(const std::vector<std::string>& options);
   ~TestHarness();
-  void Run();
+
+  // Returns the exit status of the process.
+  int Run();
 
  private:
+  int RunMode();
+  void RunBatch(const std::string& manifest, OutputFormat format);
+  bool RunSuite(const std::string& suiteDir);
+  void RunZygote(const std::string& manifest, OutputFormat format);
+  void RunServer(const std::string& socketPath);
+
+  // Applies --font-cache-size=, --outline-cache-mb=, --memstats,
+  // --canonical and --disk-cache= to all workers.
+  void ConfigureRunner(ParallelRunner* runner);
+  void PrintStats(const ParallelRunner& runner);
+
+  // Compares rendered output against the SVG in --expected=, prints
+  // the verdict and returns true if the two are similar.
+  bool CompareWithExpected(const std::string& testcase,
+                           const std::string& svg);
   bool HasOption(const std::string& flag) const;
   const std::string GetOption(const std::string& flag) const;
   void PrintUsageAndExit();
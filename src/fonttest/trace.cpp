@@ -0,0 +1,170 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fonttest/json.h"
+#include "fonttest/trace.h"
+
+namespace fonttest {
+
+namespace {
+
+struct Span {
+  const char* name;
+  int64_t start;  // nanoseconds since Tracer::Start()
+  int64_t end;
+  int testcase;   // index into ThreadBuffer::testcases, or -1
+};
+
+// Spans of one thread. Only that thread appends to it; the mutex is
+// uncontended except while the trace is being written.
+struct ThreadBuffer {
+  int tid;
+  int testcase;
+  std::mutex mutex;
+  std::vector<Span> spans;
+  std::vector<std::string> testcases;
+};
+
+std::mutex buffersMutex;
+std::vector<std::unique_ptr<ThreadBuffer> > buffers;  // kept until exit
+std::chrono::steady_clock::time_point startTime;
+thread_local ThreadBuffer* threadBuffer = NULL;
+
+ThreadBuffer* GetThreadBuffer() {
+  if (!threadBuffer) {
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+    buffer->testcase = -1;
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->tid = static_cast<int>(buffers.size()) + 1;
+    threadBuffer = buffer.get();
+    buffers.push_back(std::move(buffer));
+  }
+  return threadBuffer;
+}
+
+void AppendMicros(int64_t nanos, std::string* out) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%lld.%03d",
+           static_cast<long long>(nanos / 1000),
+           static_cast<int>(nanos % 1000));
+  out->append(buffer);
+}
+
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_(false);
+
+void Tracer::Start() {
+  startTime = std::chrono::steady_clock::now();
+  GetThreadBuffer();  // the calling thread becomes "main"
+  enabled_.store(true);
+}
+
+int64_t Tracer::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Tracer::AddSpan(const char* name, int64_t start, int64_t end) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  Span span;
+  span.name = name;
+  span.start = start;
+  span.end = end;
+  span.testcase = buffer->testcase;
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  buffer->spans.push_back(span);
+}
+
+int Tracer::AddTestcase(const std::string& id) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  buffer->testcases.push_back(id);
+  return static_cast<int>(buffer->testcases.size()) - 1;
+}
+
+int Tracer::SetTestcase(int testcase) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  const int previous = buffer->testcase;
+  buffer->testcase = testcase;
+  return previous;
+}
+
+bool Tracer::WriteJSON(const std::string& path, std::string* error) {
+  std::ofstream output(path.c_str(), std::ios::binary);
+  if (!output) {
+    *error = "cannot open " + path;
+    return false;
+  }
+
+  char pid[16];
+  snprintf(pid, sizeof(pid), "%d", static_cast<int>(getpid()));
+  std::string json = "{\"traceEvents\":[\n";
+  json.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":");
+  json.append(pid);
+  json.append(",\"args\":{\"name\":\"fonttest\"}}");
+
+  std::lock_guard<std::mutex> buffersLock(buffersMutex);
+  for (const auto& buffer : buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    const std::string tid = std::to_string(buffer->tid);
+    json.append(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+    json.append(pid);
+    json.append(",\"tid\":");
+    json.append(tid);
+    json.append(",\"args\":{\"name\":\"");
+    json.append(buffer->tid == 1 ? "main" : "thread " + tid);
+    json.append("\"}}");
+
+    for (const Span& span : buffer->spans) {
+      json.append(",\n{\"name\":");
+      AppendJSONString(span.name, &json);
+      json.append(",\"cat\":\"fonttest\",\"ph\":\"X\",\"pid\":");
+      json.append(pid);
+      json.append(",\"tid\":");
+      json.append(tid);
+      json.append(",\"ts\":");
+      AppendMicros(span.start, &json);
+      json.append(",\"dur\":");
+      AppendMicros(span.end - span.start, &json);
+      if (span.testcase >= 0) {
+        json.append(",\"args\":{\"testcase\":");
+        AppendJSONString(buffer->testcases[span.testcase], &json);
+        json.append("}");
+      }
+      json.append("}");
+    }
+  }
+  json.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  output << json;
+  if (!output.flush()) {
+    *error = "cannot write " + path;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace fonttest
@@ -0,0 +1,97 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_TRACE_H_
+#define FONTTEST_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace fonttest {
+
+// Records spans of time in the trace event format of Chrome's
+// about:tracing and Perfetto. Tracing is off until Start() is called;
+// until then, spans cost one relaxed atomic load. Every thread appends
+// to its own buffer, so spans can be recorded from worker threads.
+class Tracer {
+ public:
+  static void Start();
+  static bool IsEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Writes all spans recorded so far. Call after worker threads
+  // have finished.
+  static bool WriteJSON(const std::string& path, std::string* error);
+
+ private:
+  friend class TraceSpan;
+  friend class TraceTestcase;
+
+  static int64_t Now();
+  static void AddSpan(const char* name, int64_t start, int64_t end);
+  static int SetTestcase(int testcase);
+  static int AddTestcase(const std::string& id);
+
+  static std::atomic<bool> enabled_;
+};
+
+// Records the time between construction and destruction. |name| must
+// be a string literal or otherwise outlive the tracer.
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* name)
+    : name_(Tracer::IsEnabled() ? name : NULL),
+      start_(name_ ? Tracer::Now() : 0) {}
+  ~TraceSpan() {
+    if (name_) {
+      Tracer::AddSpan(name_, start_, Tracer::Now());
+    }
+  }
+
+ private:
+  TraceSpan(const TraceSpan&);
+  void operator=(const TraceSpan&);
+
+  const char* name_;
+  int64_t start_;
+};
+
+// Tags all spans of the current thread with a testcase id, such as
+// "AVAR-1/789", for as long as it is in scope.
+class TraceTestcase {
+ public:
+  explicit TraceTestcase(const std::string& id)
+    : enabled_(Tracer::IsEnabled()),
+      previous_(enabled_ ? Tracer::SetTestcase(Tracer::AddTestcase(id))
+                         : -1) {}
+  ~TraceTestcase() {
+    if (enabled_) {
+      Tracer::SetTestcase(previous_);
+    }
+  }
+
+ private:
+  TraceTestcase(const TraceTestcase&);
+  void operator=(const TraceTestcase&);
+
+  bool enabled_;
+  int previous_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_TRACE_H_
@@ -0,0 +1,370 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fonttest/xml.h"
+
+namespace fonttest {
+
+const std::string* XMLElement::GetAttribute(const std::string& name) const {
+  for (const Attribute& attribute : attributes) {
+    if (attribute.first == name) {
+      return &attribute.second;
+    }
+  }
+  return NULL;
+}
+
+void XMLElement::SetAttribute(const std::string& name,
+                              const std::string& value) {
+  for (Attribute& attribute : attributes) {
+    if (attribute.first == name) {
+      attribute.second = value;
+      return;
+    }
+  }
+  attributes.push_back(Attribute(name, value));
+}
+
+namespace {
+
+// Prefix -> namespace URI; the empty prefix is the default namespace.
+typedef std::map<std::string, std::string> NamespaceScope;
+
+class XMLParser {
+ public:
+  XMLParser(const std::string& text) : text_(text), pos_(0) {}
+
+  bool ParseDocument(std::unique_ptr<XMLElement>* root, std::string* error) {
+    NamespaceScope scope;
+    scope["xml"] = "http://www.w3.org/XML/1998/namespace";
+    if (!SkipMisc()) {
+      return Fail("malformed prolog", error);
+    }
+    if (!Peek('<')) {
+      return Fail("expected root element", error);
+    }
+    root->reset(new XMLElement);
+    if (!ParseElement(scope, root->get(), error)) {
+      return false;
+    }
+    if (!SkipMisc() || pos_ != text_.size()) {
+      return Fail("trailing characters", error);
+    }
+    return true;
+  }
+
+ private:
+  struct RawAttribute {
+    std::string name, value;
+  };
+
+  bool Fail(const std::string& message, std::string* error) {
+    if (error) {
+      *error = message + " at offset " + std::to_string(pos_);
+    }
+    return false;
+  }
+
+  bool Peek(char c) const {
+    return pos_ < text_.size() && text_[pos_] == c;
+  }
+
+  bool StartsWith(const char* s) const {
+    return text_.compare(pos_, strlen(s), s) == 0;
+  }
+
+  bool SkipPast(const char* s) {
+    size_t end = text_.find(s, pos_);
+    if (end == std::string::npos) {
+      return false;
+    }
+    pos_ = end + strlen(s);
+    return true;
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' ||
+            text_[pos_] == '\n' || text_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  // Skips whitespace, comments, processing instructions and
+  // document type declarations outside the root element.
+  bool SkipMisc() {
+    while (true) {
+      SkipWhitespace();
+      if (StartsWith("<?")) {
+        if (!SkipPast("?>")) return false;
+      } else if (StartsWith("<!--")) {
+        if (!SkipPast("-->")) return false;
+      } else if (StartsWith("<!DOCTYPE")) {
+        if (!SkipDoctype()) return false;
+      } else {
+        return true;
+      }
+    }
+  }
+
+  bool SkipDoctype() {
+    int depth = 0;
+    for (; pos_ < text_.size(); ++pos_) {
+      char c = text_[pos_];
+      if (c == '[') {
+        ++depth;
+      } else if (c == ']') {
+        --depth;
+      } else if (c == '>' && depth == 0) {
+        ++pos_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool IsNameChar(char c) {
+    return !(c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+             c == '=' || c == '/' || c == '>' || c == '<' ||
+             c == '"' || c == '\'' || c == '\0');
+  }
+
+  bool ParseName(std::string* name) {
+    size_t start = pos_;
+    while (pos_ < text_.size() && IsNameChar(text_[pos_])) {
+      ++pos_;
+    }
+    name->assign(text_, start, pos_ - start);
+    return !name->empty();
+  }
+
+  static void AppendUTF8(uint32_t c, std::string* out) {
+    if (c < 0x80) {
+      out->push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+      out->push_back(static_cast<char>(0xc0 | (c >> 6)));
+      out->push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else if (c < 0x10000) {
+      out->push_back(static_cast<char>(0xe0 | (c >> 12)));
+      out->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else {
+      out->push_back(static_cast<char>(0xf0 | (c >> 18)));
+      out->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    }
+  }
+
+  // Replaces entity and character references in |raw|.
+  static bool Unescape(const std::string& raw, std::string* out) {
+    out->clear();
+    for (size_t i = 0; i < raw.size(); ++i) {
+      if (raw[i] != '&') {
+        out->push_back(raw[i]);
+        continue;
+      }
+      size_t end = raw.find(';', i);
+      if (end == std::string::npos) {
+        return false;
+      }
+      const std::string entity = raw.substr(i + 1, end - i - 1);
+      if (entity == "lt") {
+        out->push_back('<');
+      } else if (entity == "gt") {
+        out->push_back('>');
+      } else if (entity == "amp") {
+        out->push_back('&');
+      } else if (entity == "quot") {
+        out->push_back('"');
+      } else if (entity == "apos") {
+        out->push_back('\'');
+      } else if (entity.size() > 1 && entity[0] == '#') {
+        const bool hex = (entity[1] == 'x');
+        const char* digits = entity.c_str() + (hex ? 2 : 1);
+        char* digitsEnd = NULL;
+        unsigned long c = strtoul(digits, &digitsEnd, hex ? 16 : 10);
+        if (*digits == '\0' || *digitsEnd != '\0' || c > 0x10FFFF) {
+          return false;
+        }
+        AppendUTF8(static_cast<uint32_t>(c), out);
+      } else {
+        return false;
+      }
+      i = end;
+    }
+    return true;
+  }
+
+  // Resolves a name like "xlink:href" to "{http://...}href".
+  static bool ResolveName(const std::string& name, const NamespaceScope& scope,
+                          bool useDefault, std::string* resolved) {
+    size_t colon = name.find(':');
+    std::string prefix, local = name;
+    if (colon != std::string::npos) {
+      prefix = name.substr(0, colon);
+      local = name.substr(colon + 1);
+    } else if (!useDefault) {
+      *resolved = name;
+      return true;
+    }
+
+    NamespaceScope::const_iterator iter = scope.find(prefix);
+    if (iter == scope.end()) {
+      if (prefix.empty()) {
+        *resolved = name;
+        return true;
+      }
+      return false;
+    }
+    if (iter->second.empty()) {
+      *resolved = local;
+    } else {
+      *resolved = "{" + iter->second + "}" + local;
+    }
+    return true;
+  }
+
+  bool ParseElement(const NamespaceScope& parentScope, XMLElement* element,
+                    std::string* error) {
+    ++pos_;  // '<'
+    std::string rawTag;
+    if (!ParseName(&rawTag)) {
+      return Fail("expected element name", error);
+    }
+
+    std::vector<RawAttribute> rawAttributes;
+    NamespaceScope scope(parentScope);
+    bool empty = false;
+    while (true) {
+      SkipWhitespace();
+      if (StartsWith("/>")) {
+        pos_ += 2;
+        empty = true;
+        break;
+      }
+      if (Peek('>')) {
+        ++pos_;
+        break;
+      }
+
+      RawAttribute attribute;
+      if (!ParseName(&attribute.name)) {
+        return Fail("expected attribute name", error);
+      }
+      SkipWhitespace();
+      if (!Peek('=')) {
+        return Fail("expected '='", error);
+      }
+      ++pos_;
+      SkipWhitespace();
+      if (!Peek('"') && !Peek('\'')) {
+        return Fail("expected quoted attribute value", error);
+      }
+      const char quote = text_[pos_++];
+      size_t end = text_.find(quote, pos_);
+      if (end == std::string::npos) {
+        return Fail("unterminated attribute value", error);
+      }
+      if (!Unescape(text_.substr(pos_, end - pos_), &attribute.value)) {
+        return Fail("malformed reference in attribute value", error);
+      }
+      pos_ = end + 1;
+
+      if (attribute.name == "xmlns") {
+        scope[""] = attribute.value;
+      } else if (attribute.name.compare(0, 6, "xmlns:") == 0) {
+        scope[attribute.name.substr(6)] = attribute.value;
+      } else {
+        rawAttributes.push_back(attribute);
+      }
+    }
+
+    if (!ResolveName(rawTag, scope, true, &element->tag)) {
+      return Fail("undeclared namespace prefix in " + rawTag, error);
+    }
+    for (const RawAttribute& raw : rawAttributes) {
+      std::string name;
+      if (!ResolveName(raw.name, scope, false, &name)) {
+        return Fail("undeclared namespace prefix in " + raw.name, error);
+      }
+      element->attributes.push_back(XMLElement::Attribute(name, raw.value));
+    }
+    if (empty) {
+      return true;
+    }
+
+    while (true) {
+      size_t next = text_.find('<', pos_);
+      if (next == std::string::npos) {
+        return Fail("unterminated element " + rawTag, error);
+      }
+      pos_ = next;
+      if (StartsWith("</")) {
+        pos_ += 2;
+        std::string closing;
+        if (!ParseName(&closing) || closing != rawTag) {
+          return Fail("mismatched closing tag for " + rawTag, error);
+        }
+        SkipWhitespace();
+        if (!Peek('>')) {
+          return Fail("expected '>'", error);
+        }
+        ++pos_;
+        return true;
+      } else if (StartsWith("<!--")) {
+        if (!SkipPast("-->")) {
+          return Fail("unterminated comment", error);
+        }
+      } else if (StartsWith("<![CDATA[")) {
+        if (!SkipPast("]]>")) {
+          return Fail("unterminated CDATA section", error);
+        }
+      } else if (StartsWith("<?")) {
+        if (!SkipPast("?>")) {
+          return Fail("unterminated processing instruction", error);
+        }
+      } else {
+        std::unique_ptr<XMLElement> child(new XMLElement);
+        if (!ParseElement(scope, child.get(), error)) {
+          return false;
+        }
+        element->children.push_back(std::move(child));
+      }
+    }
+  }
+
+  const std::string& text_;
+  size_t pos_;
+};
+
+}  // namespace
+
+bool ParseXML(const std::string& text, std::unique_ptr<XMLElement>* root,
+              std::string* error) {
+  XMLParser parser(text);
+  return parser.ParseDocument(root, error);
+}
+
+}  // namespace fonttest
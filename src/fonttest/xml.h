@@ -0,0 +1,51 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_XML_H_
+#define FONTTEST_XML_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fonttest {
+
+// An element of a parsed XML document. Names are qualified the way
+// Python's ElementTree does it: an element or attribute in a namespace
+// is called "{namespace-uri}local-name". Namespace declarations are not
+// kept as attributes. Character data is dropped, since neither testcase
+// discovery nor SVG comparison looks at it.
+struct XMLElement {
+  typedef std::pair<std::string, std::string> Attribute;
+
+  // Returns the value of an attribute, or NULL if it is absent.
+  const std::string* GetAttribute(const std::string& name) const;
+  void SetAttribute(const std::string& name, const std::string& value);
+
+  std::string tag;
+  std::vector<Attribute> attributes;  // in document order
+  std::vector<std::unique_ptr<XMLElement> > children;
+};
+
+// Parses a well-formed XML document. Processing instructions, comments
+// and document type declarations are skipped; entities other than the
+// predefined ones and character references are not supported.
+bool ParseXML(const std::string& text, std::unique_ptr<XMLElement>* root,
+              std::string* error);
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_XML_H_
@@ -0,0 +1,258 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fonttest/batch_runner.h"
+#include "fonttest/font_engine.h"
+#include "fonttest/renderer.h"
+#include "fonttest/zygote_runner.h"
+
+namespace fonttest {
+
+ZygoteRunner::ZygoteRunner(FontEngine* engine, int maxChildren,
+                           double timeoutSeconds)
+  : engine_(engine), renderer_(engine), format_(kFormatSVG),
+    maxChildren_(0), timeoutSeconds_(timeoutSeconds), output_(NULL),
+    nextToDeliver_(0) {
+  if (maxChildren <= 0) {
+    maxChildren = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  maxChildren_ = maxChildren > 0 ? static_cast<size_t>(maxChildren) : 1;
+}
+
+ZygoteRunner::~ZygoteRunner() {
+}
+
+void ZygoteRunner::SetOutputFormat(OutputFormat format, bool withOutlines) {
+  format_ = format;
+  renderer_.SetOutputFormat(format, withOutlines);
+}
+
+void ZygoteRunner::SetCanonicalSVG(bool canonical) {
+  renderer_.SetCanonicalSVG(canonical);
+}
+
+void ZygoteRunner::SetDiskCache(DiskCache* diskCache) {
+  renderer_.SetDiskCache(diskCache);
+}
+
+void ZygoteRunner::Run(std::istream* input, std::ostream* output) {
+  output_ = output;
+  size_t nextSequence = 0;
+  std::string line, error;
+  RenderResult cached;
+  while (std::getline(*input, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+
+    const size_t sequence = nextSequence++;
+    RenderJob job;
+    if (!BatchRunner::ParseJob(line, &job, &error)) {
+      Fail(sequence, job, "malformed batch record: " + error);
+      continue;
+    }
+    // A job from the disk cache needs no child. The lookup also hashes
+    // the font here, where the hash is kept for later jobs; children
+    // lose whatever they compute.
+    if (renderer_.LookupCached(job, &cached)) {
+      std::string formatted;
+      BatchRunner::FormatResult(job, cached, format_, &formatted);
+      Deliver(sequence, formatted);
+      continue;
+    }
+    while (children_.size() >= maxChildren_) {
+      WaitForChildren();
+    }
+    Spawn(sequence, job);
+  }
+
+  while (!children_.empty()) {
+    WaitForChildren();
+  }
+}
+
+void ZygoteRunner::Spawn(size_t sequence, const RenderJob& job) {
+  // Only the parent's cache outlives a child, so this is where fonts
+  // must be loaded for later children to find them. A font that fails
+  // to load is reported by the child, like any other error.
+  engine_->GetCachedFont(job.fontPath, job.faceIndex);
+
+  int fds[2];
+  if (pipe(fds) != 0) {
+    Fail(sequence, job, std::string("pipe() failed: ") + strerror(errno));
+    return;
+  }
+  const pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    Fail(sequence, job, std::string("fork() failed: ") + strerror(errno));
+    return;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    RenderInChild(job, fds[1]);
+  }
+
+  close(fds[1]);
+  Child child;
+  child.pid = pid;
+  child.fd = fds[0];
+  child.sequence = sequence;
+  child.job = job;
+  child.deadline = Clock::now() +
+      std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(timeoutSeconds_));
+  children_.push_back(child);
+}
+
+// Runs in the child; never returns. The child leaves with _exit(), so
+// that it does not flush output that the parent has buffered, nor run
+// destructors for state that belongs to the parent.
+void ZygoteRunner::RenderInChild(const RenderJob& job, int fd) {
+  RenderResult result;
+  renderer_.Render(job, &result);
+  std::string formatted;
+  BatchRunner::FormatResult(job, result, format_, &formatted);
+
+  const char* data = formatted.data();
+  size_t remaining = formatted.size();
+  while (remaining > 0) {
+    const ssize_t written = write(fd, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      _exit(1);
+    }
+    data += written;
+    remaining -= static_cast<size_t>(written);
+  }
+  _exit(0);
+}
+
+// Waits until at least one child has sent some output, finished or
+// run out of time, and reaps the children that are done.
+void ZygoteRunner::WaitForChildren() {
+  Clock::time_point deadline = children_[0].deadline;
+  std::vector<pollfd> fds(children_.size());
+  for (size_t i = 0; i < children_.size(); ++i) {
+    fds[i].fd = children_[i].fd;
+    fds[i].events = POLLIN;
+    fds[i].revents = 0;
+    deadline = std::min(deadline, children_[i].deadline);
+  }
+
+  const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - Clock::now());
+  const int timeoutMillis =
+      static_cast<int>(std::max<int64_t>(wait.count() + 1, 0));
+  if (poll(&fds[0], fds.size(), timeoutMillis) < 0 && errno != EINTR) {
+    std::cerr << "poll() failed: " << strerror(errno) << std::endl;
+    exit(1);
+  }
+
+  const Clock::time_point now = Clock::now();
+  std::vector<Child> running;
+  for (size_t i = 0; i < children_.size(); ++i) {
+    Child& child = children_[i];
+    bool done = false;
+    if (fds[i].revents != 0) {
+      char buffer[65536];
+      const ssize_t numRead = read(child.fd, buffer, sizeof(buffer));
+      if (numRead > 0) {
+        child.output.append(buffer, static_cast<size_t>(numRead));
+      } else if (numRead == 0 || errno != EINTR) {
+        done = true;
+      }
+    }
+    if (done) {
+      Reap(&child, false);
+    } else if (now >= child.deadline) {
+      kill(child.pid, SIGKILL);
+      Reap(&child, true);
+    } else {
+      running.push_back(child);
+    }
+  }
+  children_.swap(running);
+}
+
+void ZygoteRunner::Reap(Child* child, bool timedOut) {
+  close(child->fd);
+  int status = 0;
+  while (waitpid(child->pid, &status, 0) < 0 && errno == EINTR) {
+  }
+
+  std::stringstream error;
+  if (timedOut) {
+    error << "timed out after " << timeoutSeconds_ << " seconds";
+  } else if (WIFSIGNALED(status)) {
+    error << "crashed with signal " << WTERMSIG(status) << " ("
+          << strsignal(WTERMSIG(status)) << ")";
+  } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    error << "exited with status " << WEXITSTATUS(status);
+  } else if (child->output.empty() || child->output.back() != '\n') {
+    error << "no result from child process";
+  } else {
+    Deliver(child->sequence, child->output);
+    return;
+  }
+  Fail(child->sequence, child->job, error.str());
+}
+
+void ZygoteRunner::Fail(size_t sequence, const RenderJob& job,
+                        const std::string& error) {
+  RenderResult result;
+  result.error = error;
+  std::string formatted;
+  BatchRunner::FormatResult(job, result, format_, &formatted);
+  Deliver(sequence, formatted);
+}
+
+void ZygoteRunner::Deliver(size_t sequence, const std::string& formatted) {
+  if (sequence != nextToDeliver_) {
+    completed_[sequence] = formatted;
+    return;
+  }
+
+  *output_ << formatted;
+  ++nextToDeliver_;
+  auto iter = completed_.begin();
+  while (iter != completed_.end() && iter->first == nextToDeliver_) {
+    *output_ << iter->second;
+    ++nextToDeliver_;
+    iter = completed_.erase(iter);
+  }
+  *output_ << std::flush;
+}
+
+}  // namespace fonttest
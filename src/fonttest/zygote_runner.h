@@ -0,0 +1,100 @@
+/* Copyright 2024 Unicode Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FONTTEST_ZYGOTE_RUNNER_H_
+#define FONTTEST_ZYGOTE_RUNNER_H_
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "fonttest/glyph_run_format.h"
+#include "fonttest/renderer.h"
+
+namespace fonttest {
+
+class DiskCache;
+class FontEngine;
+
+// Renders a stream of testcases in the same input and output format as
+// BatchRunner, but every testcase in a child process that is forked from
+// this one. Like running fonttest once per testcase, a crash or a hang
+// only fails the testcase that caused it; unlike that, children start
+// with the engine initialized and their font already loaded, so they
+// skip exec, dynamic linking and library setup.
+//
+// Fonts are loaded into the engine's font cache in the parent process,
+// before forking, so that later children inherit them. The parent must
+// not have any other threads, since only the forking thread survives
+// in the child. POSIX only.
+class ZygoteRunner {
+ public:
+  // Runs up to |maxChildren| children at a time; zero means one per
+  // hardware thread. Children that take longer than |timeoutSeconds|
+  // are killed.
+  ZygoteRunner(FontEngine* engine, int maxChildren, double timeoutSeconds);
+  ~ZygoteRunner();
+
+  // Only kFormatSVG and kFormatGlyphsJSON are supported.
+  void SetOutputFormat(OutputFormat format, bool withOutlines);
+  void SetCanonicalSVG(bool canonical);
+
+  // Jobs are looked up in |diskCache| before forking, and children
+  // store what they render. Not owned.
+  void SetDiskCache(DiskCache* diskCache);
+
+  void Run(std::istream* input, std::ostream* output);
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Child {
+    pid_t pid;
+    int fd;  // read end of the pipe from the child
+    size_t sequence;
+    RenderJob job;
+    Clock::time_point deadline;
+    std::string output;
+  };
+
+  void Spawn(size_t sequence, const RenderJob& job);
+  void RenderInChild(const RenderJob& job, int fd);
+  void WaitForChildren();
+  void Reap(Child* child, bool timedOut);
+  void Fail(size_t sequence, const RenderJob& job, const std::string& error);
+  void Deliver(size_t sequence, const std::string& formatted);
+
+  FontEngine* engine_;
+  Renderer renderer_;
+  OutputFormat format_;
+  size_t maxChildren_;
+  double timeoutSeconds_;
+
+  std::vector<Child> children_;
+  std::ostream* output_;
+
+  // Formatted results waiting for their predecessors.
+  std::map<size_t, std::string> completed_;
+  size_t nextToDeliver_;
+};
+
+}  // namespace fonttest
+
+#endif  // FONTTEST_ZYGOTE_RUNNER_H_